@@ -0,0 +1,418 @@
+/***********************************************************************************
+ * File: Annealer.h
+ * @brief Contains the Annealer class for optimizing a floorplan by simulated
+ *    annealing over Normalized Polish Expressions using the Wong-Liu moves
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef ANNEALER_H
+#define ANNEALER_H
+
+#include <math.h>
+#include <vector>
+#include <random>
+#include "NPE.h"
+#include "SNode.h"
+#include "Floorplan.h"
+#include "SlicingTree.h"
+#include "CurveCache.h"
+#include "Wirelength.h"
+
+/***********************************************************************************
+ * Struct: AnnealingSchedule
+ * @brief Contains the parameters of the cooling schedule
+************************************************************************************/
+struct AnnealingSchedule
+{
+   float initialTemperature; //starting temperature, sampled from uphill moves if <= 0
+   float initialAcceptance;  //chance of accepting an average uphill move at the start
+   float coolingRate;        //temperature is multiplied by this after every step
+   int movesPerCell;         //moves attempted at each temperature for every cell
+   float freezeRatio;        //stop once the temperature falls below this fraction of the start
+   float maxRejectRatio;     //stop once a temperature step rejects more than this fraction
+   unsigned int seed;        //seed for the random number generator
+   size_t cacheBytes;        //memory for remembering sub-expression sizes, 0 for no cache
+   uint32_t cacheMinPoints;  //the fewest sizes of the children for a merge to be cached
+   bool cacheFirstMiss;      //cache a sub-expression the first time it misses, not the second
+   CurvePruning pruning;     //how far the sizes of the operators are thinned out
+   float wirelengthWeight;   //cost is area plus this times the wirelength when there are nets, not negative
+   AnnealingSchedule();
+};
+
+/***********************************************************************************
+ * Class: Annealer
+ * @brief searches for the Normalized Polish Expression of minimum cost by
+ *    perturbing it with the M1 (swap adjacent operands), M2 (complement an operator
+ *    chain) and M3 (swap an adjacent operand and operator) moves. The cost is the 
+ *    area, plus the weighted half-perimeter wirelength when given a netlist
+************************************************************************************/
+class Annealer
+{
+public:
+   float currentCost;
+   NPE bestNPE; //the best Normalized Polish Expression seen so far
+   float bestCost;
+   float bestError; //how much larger than exact bestCost may be because of pruning
+   Annealer(const CellLibrary &cells, const NPE &npe, const AnnealingSchedule &schedule, const Netlist *nets = NULL);
+   float run();
+   bool step(float temperature);
+   float initialTemperature();
+   const NPE & getNPE() const;
+   uint64_t getHash() const;
+   const CurveCache & getCache() const;
+private:
+   const CellLibrary &cells;
+   AnnealingSchedule schedule;
+   std::mt19937 random;
+   CurveCache cache; //used by the tree when the schedule gives it memory
+   SlicingTree tree; //the current expression, evaluated incrementally
+   const Netlist * nets; //NULL to only count area
+   Wirelength wirelength;
+   std::vector<Placement> placements; //the cells as last placed for the wirelength
+   std::vector<int32_t> moved;        //the cells that moved in the last placement
+   float evaluate(float cutoff);
+   Move perturb();
+   bool moveM1(Move &move);
+   bool moveM2(Move &move);
+   bool moveM3(Move &move);
+   int randomIndex(int size);
+   //the tree points at the cache, so a copy would share a cache it does not own
+   Annealer(const Annealer &);
+   Annealer & operator= (const Annealer &);
+};
+
+/***********************************************************************************
+ * Constructor: AnnealingSchedule
+ * @brief constructs the default cooling schedule
+************************************************************************************/
+AnnealingSchedule::AnnealingSchedule()
+{
+   this->initialTemperature = 0;
+   this->initialAcceptance = 0.95f;
+   this->coolingRate = 0.85f;
+   this->movesPerCell = 10;
+   this->freezeRatio = 0.001f;
+   this->maxRejectRatio = 0.97f;
+   this->seed = 1;
+   this->cacheBytes = 0;
+   this->cacheMinPoints = 64;
+   this->cacheFirstMiss = false;
+   this->wirelengthWeight = 1;
+}
+
+/***********************************************************************************
+ * Constructor: Annealer
+ * @brief constructs an annealer starting from the provided expression
+ * @param cells the cells to be arranged
+ * @param npe the Normalized Polish Expression to start from
+ * @param schedule the cooling schedule to follow
+ * @param nets the nets connecting the cells, which must outlive the annealer, or 
+ *    NULL to only count area
+************************************************************************************/
+Annealer::Annealer(const CellLibrary &cells, const NPE &npe, const AnnealingSchedule &schedule, const Netlist *nets)
+   : cells(cells), schedule(schedule), random(schedule.seed), cache(schedule.cacheBytes, schedule.cacheMinPoints, schedule.cacheFirstMiss), nets(nets)
+{
+   //the early abort on area alone is only sound when the wirelength cannot lower the cost
+   if (!(schedule.wirelengthWeight >= 0))
+   {
+      throw "Wirelength weight must not be negative!";
+   }
+   if (nets)
+   {
+      wirelength.setNetlist(nets);
+   }
+   if (schedule.cacheBytes > 0)
+   {
+      tree.setCache(&cache);
+   }
+   tree.setPruning(schedule.pruning);
+   tree.build(npe, cells);
+   this->currentCost = evaluate(INFINITY);
+   this->bestNPE = npe;
+   this->bestCost = currentCost;
+   this->bestError = tree.areaError();
+}
+
+/***********************************************************************************
+ * Function: run
+ * @brief anneals from the current expression until the schedule freezes
+ * @return the best cost found
+************************************************************************************/
+float Annealer::run()
+{
+   //a single cell has nothing to rearrange
+   if (cells.size() < 2)
+   {
+      return bestCost;
+   }
+   float temperature = schedule.initialTemperature;
+   if (temperature <= 0)
+   {
+      temperature = initialTemperature();
+   }
+   float freezeTemperature = temperature * schedule.freezeRatio;
+   int moves = schedule.movesPerCell * cells.size();
+   while (temperature > freezeTemperature)
+   {
+      int rejected = 0;
+      for (int i = 0; i < moves; i++)
+      {
+         if (!step(temperature))
+         {
+            rejected++;
+         }
+      }
+      temperature *= schedule.coolingRate;
+      //stop when almost nothing is accepted anymore
+      if ((float)rejected / moves > schedule.maxRejectRatio)
+      {
+         break;
+      }
+   }
+   return bestCost;
+}
+
+/***********************************************************************************
+ * Function: step
+ * @brief attempts a single random move, accepting it by the Metropolis criterion
+ * @param temperature the current temperature
+ * @return true if the move was accepted false if it was rejected
+************************************************************************************/
+bool Annealer::step(float temperature)
+{
+   //the Metropolis criterion accepts an uphill move when its cost is below
+   //current - T ln u, which is known before the move is evaluated
+   std::uniform_real_distribution<float> uniform(0, 1);
+   float threshold = currentCost - temperature * log(uniform(random));
+   perturb();
+   float candidateCost = evaluate(threshold);
+   if ((candidateCost > currentCost) && (candidateCost >= threshold))
+   {
+      //put back the sizes the move overwrote instead of recalculating them
+      tree.rollback();
+      return false;
+   }
+   tree.commit();
+   currentCost = candidateCost;
+   //keep track of the best solution so far
+   if (currentCost < bestCost)
+   {
+      bestNPE = tree.getNPE();
+      bestCost = currentCost;
+      bestError = tree.areaError();
+   }
+   return true;
+}
+
+/***********************************************************************************
+ * Function: initialTemperature
+ * @brief samples a random walk from the current expression and picks the
+ *    temperature at which the average uphill move is accepted with the schedule's
+ *    initial acceptance
+ * @return the starting temperature
+************************************************************************************/
+float Annealer::initialTemperature()
+{
+   NPE start = tree.getNPE();
+   float walkCost = currentCost;
+   float uphill = 0;
+   int uphillMoves = 0;
+   int samples = 2 * cells.size();
+   for (int i = 0; i < samples; i++)
+   {
+      perturb();
+      float nextCost = evaluate(INFINITY);
+      if (nextCost > walkCost)
+      {
+         uphill += nextCost - walkCost;
+         uphillMoves++;
+      }
+      walkCost = nextCost;
+      tree.commit();
+   }
+   //go back to where the walk started
+   tree.build(start, cells, true);
+   evaluate(INFINITY);
+   if (uphillMoves == 0)
+   {
+      return 1;
+   }
+   return -(uphill / uphillMoves) / log(schedule.initialAcceptance);
+}
+
+/***********************************************************************************
+ * Function: evaluate
+ * @brief evaluates the current expression. The wirelength is never negative, so
+ *    an area above the cutoff already settles it; otherwise the cells are placed
+ *    again and only the nets of the cells that moved are measured
+ * @param cutoff the cost above which the exact result is not needed
+ * @return the cost of the current expression, or INFINITY if it is above the cutoff
+************************************************************************************/
+float Annealer::evaluate(float cutoff)
+{
+   float area = tree.evaluate(cutoff);
+   if (!nets || (area == INFINITY))
+   {
+      return area;
+   }
+   tree.place(placements, moved);
+   return area + schedule.wirelengthWeight * wirelength.update(placements, moved);
+}
+
+/***********************************************************************************
+ * Function: getNPE
+ * @brief gets the current Normalized Polish Expression
+ * @return the Normalized Polish Expression as tokens
+************************************************************************************/
+const NPE & Annealer::getNPE() const
+{
+   return tree.getNPE();
+}
+
+/***********************************************************************************
+ * Function: getHash
+ * @brief gets the Zobrist hash of the current expression, kept up to date by
+ *    every move, for recognising expressions seen before
+ * @return the hash of the current expression
+************************************************************************************/
+uint64_t Annealer::getHash() const
+{
+   return tree.getState().getHash();
+}
+
+/***********************************************************************************
+ * Function: getCache
+ * @brief gets the cache of sub-expression sizes, for its statistics
+ * @return the cache
+************************************************************************************/
+const CurveCache & Annealer::getCache() const
+{
+   return cache;
+}
+
+/***********************************************************************************
+ * Function: perturb
+ * @brief applies one randomly chosen move to the expression
+ * @return the move that was applied
+************************************************************************************/
+Move Annealer::perturb()
+{
+   //M3 can fail when no swap keeps the expression normalized, fall back to the others
+   Move move;
+   bool found = false;
+   while (!found)
+   {
+      switch (randomIndex(3))
+      {
+         case 0:
+            found = moveM1(move);
+            break;
+         case 1:
+            found = moveM2(move);
+            break;
+         default:
+            found = moveM3(move);
+            break;
+      }
+   }
+   tree.apply(move);
+   return move;
+}
+
+/***********************************************************************************
+ * Function: moveM1
+ * @brief picks two operands that are adjacent when the operators are ignored, found
+ *    by their order in constant time
+ * @param move the move to be filled in
+ * @return true if a move was found
+************************************************************************************/
+bool Annealer::moveM1(Move &move)
+{
+   const NPEState &state = tree.getState();
+   if (state.operandCount() < 2)
+   {
+      return false;
+   }
+   int k = randomIndex(state.operandCount() - 1);
+   move.type = 1;
+   move.first = state.operandPosition(k);
+   move.second = state.operandPosition(k + 1);
+   return true;
+}
+
+/***********************************************************************************
+ * Function: moveM2
+ * @brief picks an operator chain to complement (V becomes H and H becomes V). A 
+ *    chain starts after every operand followed by an operator, so random operands
+ *    are tried until one is, which picks uniformly among the chains, giving up 
+ *    after as many tries as there are operands
+ * @param move the move to be filled in
+ * @return true if a move was found
+************************************************************************************/
+bool Annealer::moveM2(Move &move)
+{
+   const NPEState &state = tree.getState();
+   const NPE &npe = state.getNPE();
+   int start = -1;
+   for (int tries = 0; (tries < state.operandCount()) && (start < 0); tries++)
+   {
+      int i = state.operandPosition(randomIndex(state.operandCount()));
+      if ((i + 1 < (int)npe.size()) && isOperator(npe[i + 1]))
+      {
+         start = i + 1;
+      }
+   }
+   if (start < 0)
+   {
+      return false;
+   }
+   move.type = 2;
+   move.first = start;
+   move.second = move.first;
+   while ((move.second < (int)npe.size()) && isOperator(npe[move.second]))
+   {
+      move.second++;
+   }
+   return true;
+}
+
+/***********************************************************************************
+ * Function: moveM3
+ * @brief picks an adjacent operand and operator whose swap leaves a valid
+ *    Normalized Polish Expression. Random positions are tried with the constant
+ *    time check of the expression state, which picks uniformly among the legal 
+ *    swaps, giving up after as many tries as there are positions
+ * @param move the move to be filled in
+ * @return true if a move was found
+************************************************************************************/
+bool Annealer::moveM3(Move &move)
+{
+   const NPEState &state = tree.getState();
+   int positions = state.size() - 1;
+   for (int tries = 0; tries < positions; tries++)
+   {
+      int i = randomIndex(positions);
+      if (state.canSwapOperandOperator(i))
+      {
+         move.type = 3;
+         move.first = i;
+         move.second = i + 1;
+         return true;
+      }
+   }
+   return false;
+}
+
+/***********************************************************************************
+ * Function: randomIndex
+ * @brief picks a uniformly distributed index
+ * @param size the number of indices to pick from
+ * @return an index in [0, size)
+************************************************************************************/
+int Annealer::randomIndex(int size)
+{
+   std::uniform_int_distribution<int> distribution(0, size - 1);
+   return distribution(random);
+}
+
+#endif
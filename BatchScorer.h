@@ -0,0 +1,363 @@
+/***********************************************************************************
+ * File: BatchScorer.h
+ * @brief Contains the BatchScorer class which scores a stream of Normalized Polish
+ *    Expressions on every core and writes the costs in input order
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef BATCHSCORER_H
+#define BATCHSCORER_H
+
+#include <stdio.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "NPE.h"
+#include "CellLibrary.h"
+#include "EvalContext.h"
+#include "CurveCache.h"
+#include "Wirelength.h"
+#include "Floorplan.h"
+
+/***********************************************************************************
+ * Struct: BatchChunk
+ * @brief Contains a run of consecutive input lines and the output for them
+************************************************************************************/
+struct BatchChunk
+{
+   std::vector<std::string> lines; //only the first count are part of the chunk
+   int count;
+   std::string output; //one line per input line
+   bool ready;         //set once the output is written, cleared once it is printed
+};
+
+/***********************************************************************************
+ * Struct: BatchWorker
+ * @brief Contains what a worker thread reuses from one line to the next
+************************************************************************************/
+struct BatchWorker
+{
+   EvalContext context;   //the trees of the worker
+   NPE npe;               //the memory each line is read into
+   Wirelength wirelength; //the nets, when there are any
+   std::vector<Placement> placements; //the cells as placed for the wirelength
+};
+
+/***********************************************************************************
+ * Class: BatchScorer
+ * @brief scores expressions read one per line, writing one cost (or the reason the
+ *    line could not be scored) per line in the same order. The calling thread reads
+ *    the input in chunks, worker threads score whole chunks each with their own
+ *    context and a writer thread prints them. The chunks live in a ring that
+ *    doubles as the reorder buffer: the reader only fills a slot once the writer
+ *    has printed what it held, so however long the input is, at most window chunks
+ *    are in memory and a slow chunk holds up the reader rather than piling up
+ *    output behind it. Slots keep the memory of their lines and output for reuse.
+ *    The cost is the one the annealer reports for the same settings: the area of
+ *    the pruned curves, plus the weighted wirelength when there are nets
+************************************************************************************/
+class BatchScorer
+{
+public:
+   BatchScorer(const CellLibrary &cells, int threads = 0, int chunkLines = 1024, int window = 0);
+   void setPruning(const CurvePruning &pruning);
+   void setNetlist(const Netlist *nets, float wirelengthWeight);
+   void setCache(size_t cacheBytes, uint32_t minPoints = 64, bool firstMiss = false);
+   long long run(std::istream &in, std::ostream &out);
+private:
+   const CellLibrary &cells;
+   CurvePruning pruning;
+   const Netlist * nets;   //NULL to only score area
+   float wirelengthWeight;
+   size_t cacheBytes;      //the memory of the caches of every worker together, 0 for none
+   uint32_t cacheMinPoints;
+   bool cacheFirstMiss;
+   int threads;     //the worker threads
+   int chunkLines;  //the most lines in a chunk
+   std::vector<BatchChunk> slots; //the ring of chunks, indexed by sequence % size
+   std::deque<long long> work;    //the sequences waiting for a worker
+   long long written; //the sequence of the next chunk to print
+   long long total;   //the number of chunks read, known once the input ends
+   bool finished;
+   std::mutex lock;
+   std::condition_variable workReady;
+   std::condition_variable chunkReady;
+   std::condition_variable slotFree;
+   void score();
+   void write(std::ostream &out);
+   void scoreLine(const std::string &line, BatchWorker &worker, std::string &output);
+};
+
+/***********************************************************************************
+ * Constructor: BatchScorer
+ * @brief constructs a scorer over a loaded cell library
+ * @param cells the cells the expressions refer to, only read while scoring
+ * @param threads the worker threads, 0 for every hardware thread
+ * @param chunkLines the most lines handed to a worker at once
+ * @param window the most chunks in memory at once, 0 for four per worker
+************************************************************************************/
+BatchScorer::BatchScorer(const CellLibrary &cells, int threads, int chunkLines, int window) : cells(cells)
+{
+   if (threads <= 0)
+   {
+      threads = std::thread::hardware_concurrency();
+   }
+   this->threads = std::max(threads, 1);
+   this->chunkLines = std::max(chunkLines, 1);
+   if (window <= 0)
+   {
+      window = 4 * this->threads;
+   }
+   slots.resize(window);
+   this->nets = NULL;
+   this->wirelengthWeight = 1;
+   this->cacheBytes = 0;
+   this->cacheMinPoints = 64;
+   this->cacheFirstMiss = false;
+   this->written = 0;
+   this->total = 0;
+   this->finished = false;
+}
+
+/***********************************************************************************
+ * Function: setPruning
+ * @brief sets how far the sizes of the operators are thinned out
+ * @param pruning how far the curves may be thinned out
+************************************************************************************/
+void BatchScorer::setPruning(const CurvePruning &pruning)
+{
+   this->pruning = pruning;
+}
+
+/***********************************************************************************
+ * Function: setNetlist
+ * @brief adds the weighted wirelength of nets to the cost. An expression then has
+ *    to place every cell
+ * @param nets the nets connecting the cells, which must outlive the scorer, or 
+ *    NULL to only score area
+ * @param wirelengthWeight the weight of the wirelength against the area
+************************************************************************************/
+void BatchScorer::setNetlist(const Netlist *nets, float wirelengthWeight)
+{
+   this->nets = nets;
+   this->wirelengthWeight = wirelengthWeight;
+}
+
+/***********************************************************************************
+ * Function: setCache
+ * @brief gives the workers caches of sub-expression sizes, which pay off when 
+ *    neighbouring lines share sub-expressions. Every worker has its own cache
+ * @param cacheBytes the memory of the caches of every worker together, 0 for none
+ * @param minPoints the fewest sizes of the children for a merge to be cached
+ * @param firstMiss true to admit a sub-expression the first time it misses
+************************************************************************************/
+void BatchScorer::setCache(size_t cacheBytes, uint32_t minPoints, bool firstMiss)
+{
+   this->cacheBytes = cacheBytes;
+   this->cacheMinPoints = minPoints;
+   this->cacheFirstMiss = firstMiss;
+}
+
+/***********************************************************************************
+ * Function: run
+ * @brief scores every line of the input, returning once the output is written
+ * @param in the expressions, one per line
+ * @param out where the costs are written, one per line
+ * @return the number of lines scored
+************************************************************************************/
+long long BatchScorer::run(std::istream &in, std::ostream &out)
+{
+   written = 0;
+   total = 0;
+   finished = false;
+   for (int i = 0; i < (int)slots.size(); i++)
+   {
+      slots[i].count = 0;
+      slots[i].ready = false;
+   }
+   std::vector<std::thread> workers;
+   for (int t = 0; t < threads; t++)
+   {
+      workers.push_back(std::thread(&BatchScorer::score, this));
+   }
+   std::thread writer(&BatchScorer::write, this, std::ref(out));
+
+   long long lines = 0;
+   long long sequence = 0;
+   while (in)
+   {
+      {
+         //wait for the writer to print what the slot held
+         std::unique_lock<std::mutex> guard(lock);
+         slotFree.wait(guard, [&]{ return sequence - written < (long long)slots.size(); });
+      }
+      BatchChunk &chunk = slots[sequence % slots.size()];
+      if ((int)chunk.lines.size() < chunkLines)
+      {
+         chunk.lines.resize(chunkLines);
+      }
+      chunk.count = 0;
+      while ((chunk.count < chunkLines) && std::getline(in, chunk.lines[chunk.count]))
+      {
+         chunk.count++;
+      }
+      if (chunk.count == 0)
+      {
+         break;
+      }
+      lines += chunk.count;
+      {
+         std::lock_guard<std::mutex> guard(lock);
+         work.push_back(sequence++);
+      }
+      workReady.notify_one();
+   }
+   {
+      std::lock_guard<std::mutex> guard(lock);
+      total = sequence;
+      finished = true;
+   }
+   workReady.notify_all();
+   chunkReady.notify_all();
+   for (int t = 0; t < threads; t++)
+   {
+      workers[t].join();
+   }
+   writer.join();
+   out.flush();
+   return lines;
+}
+
+/***********************************************************************************
+ * Function: score
+ * @brief the loop of a worker thread: scores chunks until the input ends
+************************************************************************************/
+void BatchScorer::score()
+{
+   BatchWorker worker;
+   worker.context.tree.setPruning(pruning);
+   //the workers share out the memory of the caches
+   CurveCache cache(cacheBytes / threads, cacheMinPoints, cacheFirstMiss);
+   if (cacheBytes > 0)
+   {
+      worker.context.tree.setCache(&cache);
+   }
+   if (nets)
+   {
+      worker.wirelength.setNetlist(nets);
+   }
+   while (true)
+   {
+      long long sequence;
+      {
+         std::unique_lock<std::mutex> guard(lock);
+         workReady.wait(guard, [&]{ return !work.empty() || finished; });
+         if (work.empty())
+         {
+            return;
+         }
+         sequence = work.front();
+         work.pop_front();
+      }
+      BatchChunk &chunk = slots[sequence % slots.size()];
+      chunk.output.clear();
+      for (int i = 0; i < chunk.count; i++)
+      {
+         scoreLine(chunk.lines[i], worker, chunk.output);
+      }
+      {
+         std::lock_guard<std::mutex> guard(lock);
+         chunk.ready = true;
+      }
+      chunkReady.notify_one();
+   }
+}
+
+/***********************************************************************************
+ * Function: write
+ * @brief the loop of the writer thread: prints the chunks in the order they were
+ *    read, waiting for each in turn
+ * @param out where the costs are written
+************************************************************************************/
+void BatchScorer::write(std::ostream &out)
+{
+   while (true)
+   {
+      BatchChunk * chunk;
+      {
+         std::unique_lock<std::mutex> guard(lock);
+         chunkReady.wait(guard, [&]{ return slots[written % slots.size()].ready || (finished && (written == total)); });
+         chunk = &slots[written % slots.size()];
+         if (!chunk->ready)
+         {
+            return;
+         }
+      }
+      out.write(chunk->output.data(), chunk->output.size());
+      {
+         std::lock_guard<std::mutex> guard(lock);
+         chunk->ready = false;
+         written++;
+      }
+      slotFree.notify_one();
+   }
+}
+
+/***********************************************************************************
+ * Function: scoreLine
+ * @brief scores one line, writing its cost or the reason it could not be scored
+ * @param line the expression as text
+ * @param worker what the calling thread reuses from line to line
+ * @param output the text the result is added to
+************************************************************************************/
+void BatchScorer::scoreLine(const std::string &line, BatchWorker &worker, std::string &output)
+{
+   NPE &npe = worker.npe;
+   try
+   {
+      //lines ending in \r\n are read the same as lines ending in \n
+      if (!line.empty() && (line[line.size() - 1] == '\r'))
+      {
+         parseNPE(line.substr(0, line.size() - 1), cells, npe);
+      }
+      else
+      {
+         parseNPE(line, cells, npe);
+      }
+      if (!isValidNPE(npe, cells.size()))
+      {
+         throw "Invalid NPE!";
+      }
+      float score = cost(npe, cells, worker.context, true);
+      if (nets)
+      {
+         //a cell left out of the expression has no place to measure its nets from
+         if ((int)npe.size() != 2 * cells.size() - 1)
+         {
+            throw "Every cell must be placed to measure the nets!";
+         }
+         //the reference merge leaves the flat tree alone, so it is built to place the cells
+         if (SNode::mergeMode == SNode::REFERENCE)
+         {
+            worker.context.tree.build(npe, cells, true);
+         }
+         worker.context.tree.place(worker.placements);
+         score += wirelengthWeight * worker.wirelength.total(worker.placements);
+      }
+      char text[32];
+      int size = snprintf(text, sizeof(text), "%g\n", score);
+      output.append(text, size);
+   }
+   catch (const char * message)
+   {
+      output.append(message);
+      output.push_back('\n');
+   }
+}
+
+#endif
@@ -0,0 +1,136 @@
+/***********************************************************************************
+ * File: CellLibrary.h
+ * @brief Contains the CellLibrary class which stores the cells of a floorplan
+ *    indexed by ID and by name
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef CELLLIBRARY_H
+#define CELLLIBRARY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include "NPE.h"
+#include "SNode.h"
+
+/***********************************************************************************
+ * Class: CellLibrary
+ * @brief the cells of a floorplan. Every cell gets the next integer ID as it is
+ *    added, which is its position in cells and the token used for it in an NPE,
+ *    so an operand is found in constant time. Names are only needed to read and
+ *    write expressions as text. Pointers to the cells stay valid as long as no
+ *    cell is added, so the library is filled before any tree is built. After that
+ *    it is only read, through const references, so any number of threads can 
+ *    evaluate against the same library without locks or copies of the cells
+************************************************************************************/
+class CellLibrary
+{
+public:
+   std::vector<SNode> cells;
+   int32_t add(SNode cell);
+   void reserve(int count);
+   const SNode * find(int32_t id) const;
+   int32_t findName(const std::string &name) const;
+   int size() const;
+   bool singleCharacterNames() const;
+private:
+   std::unordered_map<std::string, int32_t> ids; //the ID of every name
+};
+
+/***********************************************************************************
+ * Function: add
+ * @brief adds a cell to the library giving it the next ID
+ * @param cell the cell to be added, taken by value so a temporary is moved in
+ * @return the ID of the cell
+************************************************************************************/
+int32_t CellLibrary::add(SNode cell)
+{
+   //V and H would be read as operators and a repeated name could not be told apart
+   if ((cell.name == "V") || (cell.name == "H") || (cell.name.empty()))
+   {
+      throw "Cell name not valid!";
+   }
+   int32_t id = cells.size();
+   //a single lookup both checks for the name and claims it
+   if (!ids.emplace(cell.name, id).second)
+   {
+      throw "Duplicate cell name!";
+   }
+   cell.id = id;
+   cells.push_back(std::move(cell));
+   return id;
+}
+
+/***********************************************************************************
+ * Function: reserve
+ * @brief makes room for a number of cells so adding them does not reallocate
+ * @param count the number of cells the library will hold
+************************************************************************************/
+void CellLibrary::reserve(int count)
+{
+   cells.reserve(count);
+   ids.reserve(count);
+}
+
+/***********************************************************************************
+ * Function: find
+ * @brief looks up a cell by ID
+ * @param id the ID of the cell
+ * @return a pointer to the cell or NULL if there is no cell with that ID
+************************************************************************************/
+const SNode * CellLibrary::find(int32_t id) const
+{
+   if ((id < 0) || (id >= (int32_t)cells.size()))
+   {
+      return NULL;
+   }
+   return &cells[id];
+}
+
+/***********************************************************************************
+ * Function: findName
+ * @brief looks up the ID of a cell by name
+ * @param name the name of the cell
+ * @return the ID of the cell or -1 if there is no cell of that name
+************************************************************************************/
+int32_t CellLibrary::findName(const std::string &name) const
+{
+   std::unordered_map<std::string, int32_t>::const_iterator item = ids.find(name);
+   if (item == ids.end())
+   {
+      return -1;
+   }
+   return item->second;
+}
+
+/***********************************************************************************
+ * Function: size
+ * @brief gets the number of cells
+ * @return the number of cells
+************************************************************************************/
+int CellLibrary::size() const
+{
+   return cells.size();
+}
+
+/***********************************************************************************
+ * Function: singleCharacterNames
+ * @brief checks if every name is a single character, in which case expressions
+ *    can be written without separating the tokens
+ * @return true if every name is a single character
+************************************************************************************/
+bool CellLibrary::singleCharacterNames() const
+{
+   for (int i = 0; i < (int)cells.size(); i++)
+   {
+      if (cells[i].name.size() != 1)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+#endif
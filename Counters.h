@@ -0,0 +1,211 @@
+/***********************************************************************************
+ * File: Counters.h
+ * @brief Contains the counters and timers of the evaluator, compiled in only when
+ *    FLOORPLAN_COUNTERS is defined and otherwise expanding to nothing
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#ifdef FLOORPLAN_COUNTERS
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+
+/***********************************************************************************
+ * Struct: Counters
+ * @brief Contains every count kept about the evaluation
+************************************************************************************/
+struct Counters
+{
+   uint64_t generateTreeCalls;   //trees built by generateTree
+   uint64_t treeBuilds;          //trees built by SlicingTree::build
+   uint64_t isValidNPECalls;
+   uint64_t isValidNPENanoseconds;
+   uint64_t nodeVisits;          //operators whose sizes were combined
+   uint64_t evaluationsCut;      //evaluations stopped early by their cutoff
+   uint64_t candidatePairs;      //pairs of child sizes tried
+   uint64_t dimensionsAccepted;  //sizes kept by addToDimensions
+   uint64_t dimensionsRejected;  //sizes turned away by addToDimensions
+   uint64_t dimensionsErased;    //sizes removed by a better one in addToDimensions
+   uint64_t peakSizes;           //longest list of sizes of any node
+   Counters();
+   void merge(const Counters &other);
+   void write(std::ostream &out) const;
+};
+
+/***********************************************************************************
+ * Class: CounterTotals
+ * @brief the counts of every thread that has finished, written as JSON to the
+ *    standard error when the program exits
+************************************************************************************/
+class CounterTotals
+{
+public:
+   ~CounterTotals();
+   void merge(const Counters &counters);
+private:
+   std::mutex lock;
+   Counters totals;
+};
+
+/***********************************************************************************
+ * Struct: ThreadCounters
+ * @brief the counts of one thread, kept without locking and added to the totals
+ *    when the thread exits
+************************************************************************************/
+struct ThreadCounters
+{
+   Counters values;
+   ~ThreadCounters();
+};
+
+/***********************************************************************************
+ * Class: CounterTimer
+ * @brief adds the nanoseconds between its construction and destruction to a count
+************************************************************************************/
+class CounterTimer
+{
+public:
+   CounterTimer(uint64_t &nanoseconds);
+   ~CounterTimer();
+private:
+   uint64_t &nanoseconds;
+   std::chrono::steady_clock::time_point start;
+};
+
+//the totals are constructed before and destroyed after every thread's counts
+CounterTotals counterTotals;
+thread_local ThreadCounters threadCounters;
+
+#define COUNTER_INCREMENT(counter) (threadCounters.values.counter++)
+#define COUNTER_ADD(counter, amount) (threadCounters.values.counter += (amount))
+#define COUNTER_MAX(counter, value) \
+   (threadCounters.values.counter = std::max<uint64_t>(threadCounters.values.counter, (value)))
+#define COUNTER_TIMER(counter) CounterTimer counterTimer(threadCounters.values.counter)
+
+/***********************************************************************************
+ * Constructor: Counters
+ * @brief constructs the counts at zero
+************************************************************************************/
+Counters::Counters()
+{
+   this->generateTreeCalls = 0;
+   this->treeBuilds = 0;
+   this->isValidNPECalls = 0;
+   this->isValidNPENanoseconds = 0;
+   this->nodeVisits = 0;
+   this->evaluationsCut = 0;
+   this->candidatePairs = 0;
+   this->dimensionsAccepted = 0;
+   this->dimensionsRejected = 0;
+   this->dimensionsErased = 0;
+   this->peakSizes = 0;
+}
+
+/***********************************************************************************
+ * Function: merge
+ * @brief adds the counts of another thread to these
+ * @param other the counts to add
+************************************************************************************/
+void Counters::merge(const Counters &other)
+{
+   generateTreeCalls += other.generateTreeCalls;
+   treeBuilds += other.treeBuilds;
+   isValidNPECalls += other.isValidNPECalls;
+   isValidNPENanoseconds += other.isValidNPENanoseconds;
+   nodeVisits += other.nodeVisits;
+   evaluationsCut += other.evaluationsCut;
+   candidatePairs += other.candidatePairs;
+   dimensionsAccepted += other.dimensionsAccepted;
+   dimensionsRejected += other.dimensionsRejected;
+   dimensionsErased += other.dimensionsErased;
+   peakSizes = std::max(peakSizes, other.peakSizes);
+}
+
+/***********************************************************************************
+ * Function: write
+ * @brief writes the counts as a JSON object
+ * @param out the output stream to write onto
+************************************************************************************/
+void Counters::write(std::ostream &out) const
+{
+   out << "{\n"
+       << "  \"generateTreeCalls\": " << generateTreeCalls << ",\n"
+       << "  \"treeBuilds\": " << treeBuilds << ",\n"
+       << "  \"isValidNPECalls\": " << isValidNPECalls << ",\n"
+       << "  \"isValidNPENanoseconds\": " << isValidNPENanoseconds << ",\n"
+       << "  \"nodeVisits\": " << nodeVisits << ",\n"
+       << "  \"evaluationsCut\": " << evaluationsCut << ",\n"
+       << "  \"candidatePairs\": " << candidatePairs << ",\n"
+       << "  \"dimensionsAccepted\": " << dimensionsAccepted << ",\n"
+       << "  \"dimensionsRejected\": " << dimensionsRejected << ",\n"
+       << "  \"dimensionsErased\": " << dimensionsErased << ",\n"
+       << "  \"peakSizes\": " << peakSizes << "\n"
+       << "}\n";
+}
+
+/***********************************************************************************
+ * Destructor: CounterTotals
+ * @brief writes the totals once every thread has finished
+************************************************************************************/
+CounterTotals::~CounterTotals()
+{
+   totals.write(std::cerr);
+}
+
+/***********************************************************************************
+ * Function: merge
+ * @brief adds the counts of a finished thread to the totals
+ * @param counters the counts of the thread
+************************************************************************************/
+void CounterTotals::merge(const Counters &counters)
+{
+   std::lock_guard<std::mutex> guard(lock);
+   totals.merge(counters);
+}
+
+/***********************************************************************************
+ * Destructor: ThreadCounters
+ * @brief adds the counts of the exiting thread to the totals
+************************************************************************************/
+ThreadCounters::~ThreadCounters()
+{
+   counterTotals.merge(values);
+}
+
+/***********************************************************************************
+ * Constructor: CounterTimer
+ * @brief starts timing
+ * @param nanoseconds the count the time is added to
+************************************************************************************/
+CounterTimer::CounterTimer(uint64_t &nanoseconds)
+   : nanoseconds(nanoseconds), start(std::chrono::steady_clock::now())
+{
+}
+
+/***********************************************************************************
+ * Destructor: CounterTimer
+ * @brief adds the time since construction to the count
+************************************************************************************/
+CounterTimer::~CounterTimer()
+{
+   nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+#else
+
+//without FLOORPLAN_COUNTERS nothing is counted and the arguments are not evaluated
+#define COUNTER_INCREMENT(counter) ((void)0)
+#define COUNTER_ADD(counter, amount) ((void)0)
+#define COUNTER_MAX(counter, value) ((void)0)
+#define COUNTER_TIMER(counter) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,310 @@
+/***********************************************************************************
+ * File: CurveCache.h
+ * @brief Contains the CurveCache class which remembers the sizes of sub-expressions
+ *    so a subtree seen before does not have to be merged again
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef CURVECACHE_H
+#define CURVECACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <unordered_map>
+#include <string.h>
+#include "NPE.h"
+#include "ShapeCurve.h"
+
+/***********************************************************************************
+ * Struct: CacheEntry
+ * @brief Contains one remembered sub-expression and its sizes
+************************************************************************************/
+struct CacheEntry
+{
+   uint64_t key;     //the hash of the sub-expression
+   NPE tokens;       //the sub-expression itself, compared on every hit
+   ShapeCurve curve; //the sizes of the sub-expression
+   float error;      //the factor by which pruning may have enlarged the sizes
+   bool referenced;  //set by every hit, cleared as the clock hand passes
+   bool used;        //false for a free slot
+};
+
+/***********************************************************************************
+ * Class: CurveCache
+ * @brief bounded map from the hash of a sub-expression to its sizes. Entries are
+ *    evicted by the CLOCK policy once the memory held would pass the cap: the hand
+ *    sweeps the slots, giving every entry hit since its last pass a second chance.
+ *    The cap covers everything the cache allocates, the capacity of the sizes, the
+ *    slots, the nodes and buckets of the map and the filter, and an evicted slot
+ *    gives the memory of its sizes back rather than keeping it. A hit only 
+ *    replaces a linear merge with a copy, while every miss pays for a copy and an
+ *    insertion, so by default only merges of at least minPoints sizes are 
+ *    remembered, and a sub-expression is only admitted the second time it misses.
+ *    The first miss just records its hash in a small direct-mapped filter, so the
+ *    many sub-expressions that are never seen again cost no copy. Each entry keeps the
+ *    tokens of its sub-expression, and a hit is only returned if they match, so
+ *    two sub-expressions whose hashes collide never share sizes
+************************************************************************************/
+class CurveCache
+{
+public:
+   uint64_t hits;
+   uint64_t misses;
+   uint64_t evictions;
+   uint64_t collisions; //lookups whose hash matched a different sub-expression
+   uint32_t minPoints; //the fewest sizes of the children for a merge to be cached
+   bool firstMiss;     //admit a sub-expression on its first miss instead of its second
+   CurveCache(size_t maxBytes, uint32_t minPoints = 64, bool firstMiss = false);
+   const CacheEntry * find(uint64_t key, const int32_t * tokens, uint32_t count);
+   void insert(uint64_t key, const int32_t * tokens, uint32_t count, const ShapeCurve &curve, float error);
+   void clear();
+   size_t size() const;
+   size_t memory() const;
+   float hitRate() const;
+private:
+   std::vector<CacheEntry> entries;
+   std::vector<int> freeSlots;
+   std::unordered_map<uint64_t, int> slots; //the slot of every key
+   std::vector<uint64_t> seen; //the last key to miss in every bucket of the filter
+   size_t maxBytes;
+   size_t bytes; //the memory of the sizes of the entries
+   int hand;
+   static size_t footprint(const CacheEntry &entry);
+   size_t growth(uint32_t count, const ShapeCurve &curve) const;
+   void evict();
+};
+
+/***********************************************************************************
+ * Constructor: CurveCache
+ * @brief constructs an empty cache
+ * @param maxBytes the most memory the sizes of the entries may use
+ * @param minPoints the fewest sizes of the children for a merge to be cached
+ * @param firstMiss true to admit a sub-expression the first time it misses
+************************************************************************************/
+CurveCache::CurveCache(size_t maxBytes, uint32_t minPoints, bool firstMiss)
+{
+   this->minPoints = minPoints;
+   this->firstMiss = firstMiss;
+   this->seen.assign(4096, 0);
+   this->hits = 0;
+   this->misses = 0;
+   this->evictions = 0;
+   this->collisions = 0;
+   this->maxBytes = maxBytes;
+   this->bytes = 0;
+   this->hand = 0;
+}
+
+/***********************************************************************************
+ * Function: find
+ * @brief looks up the sizes of a sub-expression
+ * @param key the hash of the sub-expression
+ * @param tokens the sub-expression
+ * @param count the number of tokens
+ * @return a pointer to the entry, valid until the next insert, or NULL if absent
+************************************************************************************/
+const CacheEntry * CurveCache::find(uint64_t key, const int32_t * tokens, uint32_t count)
+{
+   std::unordered_map<uint64_t, int>::iterator item = slots.find(key);
+   if (item == slots.end())
+   {
+      misses++;
+      return NULL;
+   }
+   CacheEntry &entry = entries[item->second];
+   if ((entry.tokens.size() != count) || (memcmp(entry.tokens.data(), tokens, count * sizeof(int32_t)) != 0))
+   {
+      collisions++;
+      misses++;
+      return NULL;
+   }
+   hits++;
+   entry.referenced = true;
+   return &entry;
+}
+
+/***********************************************************************************
+ * Function: insert
+ * @brief remembers the sizes of a sub-expression, evicting entries until they fit.
+ *    Unless firstMiss is set, the first time a key misses only the key is noted.
+ *    Sizes larger than the whole cache are not remembered. A key already held by another 
+ *    sub-expression keeps that one
+ * @param key the hash of the sub-expression
+ * @param tokens the sub-expression
+ * @param count the number of tokens
+ * @param curve the sizes of the sub-expression
+ * @param error the factor by which pruning may have enlarged the sizes
+************************************************************************************/
+void CurveCache::insert(uint64_t key, const int32_t * tokens, uint32_t count, const ShapeCurve &curve, float error)
+{
+   if (slots.count(key) != 0)
+   {
+      return;
+   }
+   uint64_t &bucket = seen[key & (seen.size() - 1)];
+   if (!firstMiss && (bucket != key))
+   {
+      bucket = key;
+      return;
+   }
+   //evicting frees a slot, which can change what the new entry needs
+   while (memory() + growth(count, curve) > maxBytes)
+   {
+      if (slots.empty())
+      {
+         return;
+      }
+      evict();
+   }
+   int slot;
+   if (freeSlots.empty())
+   {
+      slot = entries.size();
+      entries.push_back(CacheEntry());
+      //an eviction never has to grow the list of free slots
+      freeSlots.reserve(entries.capacity());
+   }
+   else
+   {
+      slot = freeSlots.back();
+      freeSlots.pop_back();
+   }
+   CacheEntry &entry = entries[slot];
+   entry.key = key;
+   entry.tokens.assign(tokens, tokens + count);
+   //copied into the empty buffers of a free slot, so they are no larger than needed
+   entry.curve = curve;
+   entry.error = error;
+   entry.referenced = false;
+   entry.used = true;
+   slots[key] = slot;
+   bytes += footprint(entry);
+}
+
+/***********************************************************************************
+ * Function: clear
+ * @brief forgets every entry, the statistics are kept
+************************************************************************************/
+void CurveCache::clear()
+{
+   std::vector<CacheEntry>().swap(entries);
+   seen.assign(seen.size(), 0);
+   std::vector<int>().swap(freeSlots);
+   std::unordered_map<uint64_t, int>().swap(slots);
+   bytes = 0;
+   hand = 0;
+}
+
+/***********************************************************************************
+ * Function: size
+ * @brief gets the number of entries
+ * @return the number of entries
+************************************************************************************/
+size_t CurveCache::size() const
+{
+   return slots.size();
+}
+
+/***********************************************************************************
+ * Function: memory
+ * @brief gets the memory counted against the cap, everything the cache allocates.
+ *    A node of the map is counted as its link, its pair and a cached hash
+ * @return the memory used by the cache in bytes
+************************************************************************************/
+size_t CurveCache::memory() const
+{
+   size_t node = sizeof(void *) + sizeof(std::pair<const uint64_t, int>) + sizeof(size_t);
+   return bytes + entries.capacity() * sizeof(CacheEntry) + freeSlots.capacity() * sizeof(int) +
+          slots.size() * node + slots.bucket_count() * sizeof(void *) + seen.capacity() * sizeof(uint64_t);
+}
+
+/***********************************************************************************
+ * Function: hitRate
+ * @brief gets the fraction of lookups that found their sub-expression
+ * @return the hit rate, 0 before any lookup
+************************************************************************************/
+float CurveCache::hitRate() const
+{
+   if (hits + misses == 0)
+   {
+      return 0;
+   }
+   return (float)hits / (hits + misses);
+}
+
+/***********************************************************************************
+ * Function: footprint
+ * @brief gets the memory held by the tokens and sizes of an entry
+ * @param entry the entry
+ * @return the memory of the buffers of the entry in bytes
+************************************************************************************/
+size_t CurveCache::footprint(const CacheEntry &entry)
+{
+   const ShapeCurve &curve = entry.curve;
+   return entry.tokens.capacity() * sizeof(int32_t) +
+          (curve.width.capacity() + curve.height.capacity()) * sizeof(float) +
+          (curve.rSelected.capacity() + curve.lSelected.capacity()) * sizeof(uint32_t);
+}
+
+/***********************************************************************************
+ * Function: growth
+ * @brief gets how much the memory of the cache grows by inserting an entry: its
+ *    tokens, sizes and node, and whatever the slots and the buckets of the map 
+ *    take to make room for it
+ * @param count the number of tokens of the new entry
+ * @param curve the sizes of the new entry
+ * @return the extra memory in bytes
+************************************************************************************/
+size_t CurveCache::growth(uint32_t count, const ShapeCurve &curve) const
+{
+   size_t needed = count * sizeof(int32_t) + curve.size() * (2 * sizeof(float) + 2 * sizeof(uint32_t)) +
+                   sizeof(void *) + sizeof(std::pair<const uint64_t, int>) + sizeof(size_t);
+   if (freeSlots.empty() && (entries.size() == entries.capacity()))
+   {
+      //the slots double, and the free list is kept as long as them
+      needed += std::max(entries.capacity(), (size_t)1) * (sizeof(CacheEntry) + sizeof(int));
+   }
+   if (slots.size() + 1 > slots.bucket_count() * slots.max_load_factor())
+   {
+      //rehashing at least doubles the buckets
+      needed += std::max(slots.bucket_count(), (size_t)8) * 2 * sizeof(void *);
+   }
+   return needed;
+}
+
+/***********************************************************************************
+ * Function: evict
+ * @brief advances the clock hand to the first entry not hit since its last pass
+ *    and frees it
+************************************************************************************/
+void CurveCache::evict()
+{
+   while (true)
+   {
+      CacheEntry &entry = entries[hand];
+      hand = (hand + 1) % entries.size();
+      if (!entry.used)
+      {
+         continue;
+      }
+      if (entry.referenced)
+      {
+         entry.referenced = false;
+         continue;
+      }
+      entry.used = false;
+      slots.erase(entry.key);
+      freeSlots.push_back(&entry - &entries[0]);
+      bytes -= footprint(entry);
+      //give the memory of the tokens and sizes back so the cap holds
+      NPE().swap(entry.tokens);
+      entry.curve = ShapeCurve();
+      evictions++;
+      return;
+   }
+}
+
+#endif
@@ -0,0 +1,282 @@
+/***********************************************************************************
+ * File: DesignFile.h
+ * @brief Contains the binary design format, a header followed by packed arrays of
+ *    the cells, along with the functions that write it and read it from a mapping
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef DESIGNFILE_H
+#define DESIGNFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <utility>
+#include "SNode.h"
+#include "CellLibrary.h"
+
+const char designMagic[8] = {'F', 'L', 'O', 'O', 'R', 'P', 'L', 'N'};
+const uint32_t designVersion = 1;
+const uint32_t designByteOrder = 0x01020304; //reads differently on a machine of the other byte order
+
+/***********************************************************************************
+ * Struct: DesignHeader
+ * @brief Contains the start of a binary design file. Every offset is in bytes from
+ *    the start of the file and a multiple of 8, and the arrays are:
+ *       area, aspectRatio   float[cellCount]
+ *       fixed               uint8_t[cellCount]
+ *       optionStart         uint32_t[cellCount+1], the options of cell c are
+ *                           optionStart[c] to optionStart[c+1]-1
+ *       optionWidth/Height  float[optionCount], sorted by width within a cell
+ *       optionTag           uint32_t[optionCount], the index of the option a size
+ *                           comes from shifted left once, with 1 in the low bit
+ *                           if it is rotated
+ *       nameStart           uint32_t[cellCount+1], into names
+ *       names               char[nameBytes], not null terminated
+ *    The values are stored in the byte order of the machine that wrote them, so a
+ *    file is only read on a machine of the same order
+************************************************************************************/
+struct DesignHeader
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t byteOrder;
+   uint32_t cellCount;
+   uint32_t optionCount;
+   uint32_t nameBytes;
+   uint32_t reserved;
+   uint64_t area;
+   uint64_t aspectRatio;
+   uint64_t fixed;
+   uint64_t optionStart;
+   uint64_t optionWidth;
+   uint64_t optionHeight;
+   uint64_t optionTag;
+   uint64_t nameStart;
+   uint64_t names;
+   uint64_t fileSize;
+};
+
+static_assert(sizeof(DesignHeader) % 8 == 0, "the arrays after the header must stay aligned");
+
+bool isDesignFile(const char * data, size_t size);
+bool validDimension(float value);
+void readDesign(const char * data, size_t size, CellLibrary &cells);
+void writeDesign(const std::string &filename, const CellLibrary &cells);
+
+/***********************************************************************************
+ * Function: isDesignFile
+ * @brief checks if the contents of a file start like a binary design
+ * @param data the contents of the file
+ * @param size the number of bytes in data
+ * @return true if the file starts with the magic of the format
+************************************************************************************/
+bool isDesignFile(const char * data, size_t size)
+{
+   return (size >= sizeof(designMagic)) && (memcmp(data, designMagic, sizeof(designMagic)) == 0);
+}
+
+/***********************************************************************************
+ * Function: designArray
+ * @brief finds an array of a binary design in place, checking it is in the file
+ * @param data the contents of the file, aligned as a mapping is
+ * @param size the number of bytes in data
+ * @param offset where the array starts
+ * @param count the number of elements
+ * @return a pointer to the first element
+************************************************************************************/
+template <typename T>
+const T * designArray(const char * data, size_t size, uint64_t offset, uint64_t count)
+{
+   if ((offset % 8 != 0) || (offset > size) || (count > (size - offset) / sizeof(T)))
+   {
+      throw "Design file not valid!";
+   }
+   return (const T *)(data + offset);
+}
+
+/***********************************************************************************
+ * Function: validDimension
+ * @brief checks a stored area, aspect ratio, width or height
+ * @param value the stored value
+ * @return true if the value is positive and finite
+************************************************************************************/
+bool validDimension(float value)
+{
+   return (value > 0) && isfinite(value);
+}
+
+/***********************************************************************************
+ * Function: readDesign
+ * @brief adds the cells of a binary design to a library. The arrays are read where
+ *    they lie in the mapping, so no number is parsed, and the values are copied
+ *    into the cells of the library, which own their sizes. The sizes are taken as
+ *    stored rather than recalculated, once they are checked to be positive,
+ *    finite and a valid shape curve: sorted by width with every size shorter than
+ *    the one before
+ * @param data the contents of the file, aligned as a mapping is
+ * @param size the number of bytes in data
+ * @param cells the library the cells are added to
+************************************************************************************/
+void readDesign(const char * data, size_t size, CellLibrary &cells)
+{
+   if ((size < sizeof(DesignHeader)) || !isDesignFile(data, size))
+   {
+      throw "Design file not valid!";
+   }
+   const DesignHeader * header = (const DesignHeader *)data;
+   if (header->byteOrder != designByteOrder)
+   {
+      throw "Design file has the wrong byte order!";
+   }
+   if (header->version != designVersion)
+   {
+      throw "Design file version not supported!";
+   }
+   if (header->fileSize != size)
+   {
+      throw "Design file not valid!";
+   }
+   uint32_t count = header->cellCount;
+   const float * area = designArray<float>(data, size, header->area, count);
+   const float * aspectRatio = designArray<float>(data, size, header->aspectRatio, count);
+   const uint8_t * fixed = designArray<uint8_t>(data, size, header->fixed, count);
+   const uint32_t * optionStart = designArray<uint32_t>(data, size, header->optionStart, (uint64_t)count + 1);
+   const float * optionWidth = designArray<float>(data, size, header->optionWidth, header->optionCount);
+   const float * optionHeight = designArray<float>(data, size, header->optionHeight, header->optionCount);
+   const uint32_t * optionTag = designArray<uint32_t>(data, size, header->optionTag, header->optionCount);
+   const uint32_t * nameStart = designArray<uint32_t>(data, size, header->nameStart, (uint64_t)count + 1);
+   const char * names = designArray<char>(data, size, header->names, header->nameBytes);
+   if ((optionStart[0] != 0) || (optionStart[count] != header->optionCount) ||
+       (nameStart[0] != 0) || (nameStart[count] != header->nameBytes))
+   {
+      throw "Design file not valid!";
+   }
+   cells.reserve(cells.size() + count);
+   for (uint32_t c = 0; c < count; c++)
+   {
+      //every cell needs a size and a name
+      if ((optionStart[c] >= optionStart[c + 1]) || (optionStart[c + 1] > header->optionCount) ||
+          (nameStart[c] > nameStart[c + 1]) || (nameStart[c + 1] > header->nameBytes))
+      {
+         throw "Design file not valid!";
+      }
+      if (!validDimension(area[c]) || !validDimension(aspectRatio[c]))
+      {
+         throw "Design file not valid!";
+      }
+      ShapeCurve sizes;
+      sizes.reserve(optionStart[c + 1] - optionStart[c]);
+      for (uint32_t o = optionStart[c]; o < optionStart[c + 1]; o++)
+      {
+         //the merges rely on the sizes being sorted with none beaten by another
+         if (!validDimension(optionWidth[o]) || !validDimension(optionHeight[o]) ||
+             ((o > optionStart[c]) && ((optionWidth[o] <= optionWidth[o - 1]) || (optionHeight[o] >= optionHeight[o - 1]))))
+         {
+            throw "Design file not valid!";
+         }
+         Dimensions option;
+         option.width = optionWidth[o];
+         option.height = optionHeight[o];
+         option.rSelected = optionTag[o] >> 1;
+         option.lSelected = optionTag[o] & 1;
+         sizes.push_back(option);
+      }
+      cells.add(SNode(std::string(names + nameStart[c], names + nameStart[c + 1]), area[c], aspectRatio[c], fixed[c] != 0, std::move(sizes)));
+   }
+}
+
+/***********************************************************************************
+ * Function: writeArray
+ * @brief writes an array of a binary design, padded to a multiple of 8 bytes
+ * @param fout the file being written
+ * @param values the elements of the array
+ * @return the offset of the array
+************************************************************************************/
+template <typename T>
+uint64_t writeArray(std::ofstream &fout, const std::vector<T> &values)
+{
+   uint64_t offset = fout.tellp();
+   if (!values.empty())
+   {
+      fout.write((const char *)values.data(), values.size() * sizeof(T));
+   }
+   const char padding[8] = {0};
+   size_t bytes = values.size() * sizeof(T);
+   fout.write(padding, (8 - bytes % 8) % 8);
+   return offset;
+}
+
+/***********************************************************************************
+ * Function: writeDesign
+ * @brief writes the cells of a library as a binary design, used to convert a text
+ *    cells file once so later runs load it without parsing
+ * @param filename the name of the file to write
+ * @param cells the cells to write
+************************************************************************************/
+void writeDesign(const std::string &filename, const CellLibrary &cells)
+{
+   std::vector<float> area;
+   std::vector<float> aspectRatio;
+   std::vector<uint8_t> fixed;
+   std::vector<uint32_t> optionStart(1, 0);
+   std::vector<float> optionWidth;
+   std::vector<float> optionHeight;
+   std::vector<uint32_t> optionTag;
+   std::vector<uint32_t> nameStart(1, 0);
+   std::vector<char> names;
+   for (int c = 0; c < cells.size(); c++)
+   {
+      const SNode &cell = cells.cells[c];
+      area.push_back(cell.area);
+      aspectRatio.push_back(cell.aspectRatio);
+      fixed.push_back(cell.fixed? 1 : 0);
+      for (uint32_t o = 0; o < cell.sizes.size(); o++)
+      {
+         optionWidth.push_back(cell.sizes.width[o]);
+         optionHeight.push_back(cell.sizes.height[o]);
+         optionTag.push_back((cell.sizes.rSelected[o] << 1) | cell.sizes.lSelected[o]);
+      }
+      optionStart.push_back(optionWidth.size());
+      names.insert(names.end(), cell.name.begin(), cell.name.end());
+      nameStart.push_back(names.size());
+   }
+
+   std::ofstream fout(filename, std::ios::binary);
+   if (fout.fail())
+   {
+      throw "Unable to open file";
+   }
+   //the header is written again once the offsets are known
+   DesignHeader header;
+   memset(&header, 0, sizeof(header));
+   fout.write((const char *)&header, sizeof(header));
+   memcpy(header.magic, designMagic, sizeof(designMagic));
+   header.version = designVersion;
+   header.byteOrder = designByteOrder;
+   header.cellCount = cells.size();
+   header.optionCount = optionWidth.size();
+   header.nameBytes = names.size();
+   header.area = writeArray(fout, area);
+   header.aspectRatio = writeArray(fout, aspectRatio);
+   header.fixed = writeArray(fout, fixed);
+   header.optionStart = writeArray(fout, optionStart);
+   header.optionWidth = writeArray(fout, optionWidth);
+   header.optionHeight = writeArray(fout, optionHeight);
+   header.optionTag = writeArray(fout, optionTag);
+   header.nameStart = writeArray(fout, nameStart);
+   header.names = writeArray(fout, names);
+   header.fileSize = fout.tellp();
+   fout.seekp(0);
+   fout.write((const char *)&header, sizeof(header));
+   if (fout.fail())
+   {
+      throw "Unable to write file";
+   }
+}
+
+#endif
@@ -0,0 +1,27 @@
+/***********************************************************************************
+ * File: EvalContext.h
+ * @brief Contains the EvalContext struct which holds the memory one thread needs to
+ *    evaluate expressions against a shared cell library
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef EVALCONTEXT_H
+#define EVALCONTEXT_H
+
+#include "NodeArena.h"
+#include "SlicingTree.h"
+
+/***********************************************************************************
+ * Struct: EvalContext
+ * @brief the trees and sizes used while evaluating, reused from one expression to
+ *    the next. The cell library is only ever read, so every thread evaluating
+ *    against it needs nothing more than its own context: no locks are taken and no
+ *    cells are copied into shared memory
+************************************************************************************/
+struct EvalContext
+{
+   NodeArena nodes;  //the nodes of the tree for the reference merge
+   SlicingTree tree; //the flat tree for the shape curve merge
+};
+
+#endif
@@ -0,0 +1,730 @@
+/***********************************************************************************
+ * File: Floorplan.h
+ * @brief Contains the functions for loading cells and evaluating the cost of a 
+ *    Normalized Polish Expression
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef FLOORPLAN_H
+#define FLOORPLAN_H
+
+#include <iostream> 
+#include <fstream> 
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <ctype.h>
+#include <string.h>
+#include <math.h>
+#include <charconv>
+#include "NPE.h"
+#include "SNode.h"
+#include "CellLibrary.h"
+#include "NodeArena.h"
+#include "EvalContext.h"
+#include "SlicingTree.h"
+#include "Counters.h"
+#include "MappedFile.h"
+#include "DesignFile.h"
+#include "Wirelength.h"
+
+const int maxAspectSamples = 64; //the most shapes a range of aspect ratios is sampled at
+
+//functions
+bool isValidNPE(const NPE &npe, int cellCount);
+void getCells(std::string filename, CellLibrary &cells);
+void parseCells(const char * text, size_t size, const std::string &filename, CellLibrary &cells);
+void cellError(const std::string &filename, int line, const char * reason);
+const char * skipBlanks(const char * current, const char * end);
+const char * nextToken(const char * current, const char * end, const char * &tokenEnd);
+bool readNumber(const char * first, const char * last, float &value, const std::string &filename, int line);
+bool isFixed(const char * first, const char * last);
+void getNets(std::string filename, const CellLibrary &cells, Netlist &nets);
+NPE parseNPE(const std::string &text, const CellLibrary &cells);
+void parseNPE(const std::string &text, const CellLibrary &cells, NPE &npe);
+std::string formatNPE(const NPE &npe, const CellLibrary &cells);
+float cost(const NPE &npe ,const CellLibrary &cells);
+float cost(const NPE &npe ,const CellLibrary &cells, EvalContext &context, bool trusted = false);
+float cost(const NPE &npe ,const CellLibrary &cells, NodeArena &operators);
+float cost(const NPE &npe ,const CellLibrary &cells, SlicingTree &tree);
+SNode * generateTree(const NPE &npe, const CellLibrary &cells, NodeArena &operators, bool trusted = false);
+NPE verticalNPE(const CellLibrary &cells);
+std::vector<Placement> placeNPE(const NPE &npe, const CellLibrary &cells, const CurvePruning &pruning);
+
+/***********************************************************************************
+ * Function: isValidNPE
+ * @brief verifies the the provided Normalized Polish Expression is valid in a 
+ *    single pass. Repeated operands are caught with a bitset of the cell IDs seen
+ *    so far, which belongs to the thread and only has the bits of this expression
+ *    cleared afterwards, so nothing is allocated once it is large enough. IDs are
+ *    checked against the library before they reach the bitset, so it is never 
+ *    grown past the number of cells
+ * @param npe the Normalized Polish Expression as tokens
+ * @param cellCount the number of cells in the library the IDs refer to
+ * @return true if valid false otherwise
+************************************************************************************/
+bool isValidNPE(const NPE &npe, int cellCount)
+{
+   COUNTER_INCREMENT(isValidNPECalls);
+   COUNTER_TIMER(isValidNPENanoseconds);
+   static thread_local std::vector<uint64_t> seen;
+   int operands = 0;
+   int operators = 0;
+   bool valid = true;
+   int i = 0;
+   for (; i < (int)npe.size(); i++) 
+   {
+      //if it is an operator check for repeats add to the operator count
+      if (isOperator(npe[i]))
+      {
+         //only the two cuts are operators, any other negative token is not a token
+         if ((npe[i] != verticalCut) && (npe[i] != horizontalCut))
+         {
+            valid = false;
+            break;
+         }
+         //make sure there are no repeat operators 
+         if ((i + 1 < (int)npe.size()) && (npe[i] == npe[i + 1]))
+         {
+            valid = false;
+            break;
+         }
+         operators++;
+      }
+      else //if it is an operand make sure it is unique and add to operand count
+      {
+         if (npe[i] >= cellCount)
+         {
+            valid = false;
+            break;
+         }
+         uint32_t word = npe[i] / 64;
+         uint64_t bit = (uint64_t)1 << (npe[i] % 64);
+         if (word >= seen.size())
+         {
+            seen.resize(word + 1, 0);
+         }
+         //if it was seen before return false
+         if (seen[word] & bit)
+         {
+            valid = false;
+            break;
+         }
+         seen[word] |= bit;
+         operands++;
+      }
+      //make sure it meets balloting property
+      if(operands <= operators)
+      {
+         valid = false;
+         break;
+      }
+   }
+   //clear the bits of the operands that were marked
+   for (int j = 0; j < i; j++)
+   {
+      if (!isOperator(npe[j]))
+      {
+         seen[npe[j] / 64] = 0;
+      }
+   }
+   return valid && (operators == operands - 1);
+}
+
+/***********************************************************************************
+ * Function: getCells
+ * @brief loads the cells for the floorplan from the designated file, either text
+ *    or a binary design written by writeDesign
+ * @param filename the name of the file containing the cells
+************************************************************************************/
+void getCells(std::string filename, CellLibrary &cells)
+{
+   if (filename == "")
+   {
+      std::cout << "Please enter file name: ";
+      std::cin.clear();
+      std::cin.ignore();
+      getline(std::cin,filename);
+   }
+   //the file is read straight out of the mapping, a binary design without parsing
+   MappedFile file(filename);
+   if (isDesignFile(file.data(), file.size()))
+   {
+      readDesign(file.data(), file.size(), cells);
+   }
+   else
+   {
+      parseCells(file.data(), file.size(), filename, cells);
+   }
+}
+
+/***********************************************************************************
+ * Function: cellError
+ * @brief reports a malformed line of a cells file
+ * @param filename the name of the file, used in the message
+ * @param line the number of the line, starting at 1
+ * @param reason what is wrong with the line
+************************************************************************************/
+void cellError(const std::string &filename, int line, const char * reason)
+{
+   std::cerr << filename << ":" << line << ": " << reason << "\n";
+   throw "Cell data not valid!";
+}
+
+/***********************************************************************************
+ * Function: parseCells
+ * @brief reads cells written one per line, fields separated by spaces or tabs, in
+ *    any of the forms
+ *       name area aspectRatio [fixed]
+ *       name area minAspectRatio:maxAspectRatio[:count] [fixed]
+ *       name widthxheight [widthxheight ...] [fixed]
+ *    A range is sampled at count aspect ratios spaced evenly by ratio (5 if not
+ *    given, at most maxAspectSamples), and a list gives the exact shapes the cell
+ *    can take. A fixed cell is never rotated, otherwise every shape is also tried
+ *    on its side. Blank lines are skipped. The numbers are read with
+ *    std::from_chars in place, so nothing is allocated but the cells themselves,
+ *    and a malformed line is reported with its line number
+ * @param text the contents of the file, need not be null terminated
+ * @param size the number of characters in text
+ * @param filename the name of the file, used in error messages
+ * @param cells the library the cells are added to
+************************************************************************************/
+void parseCells(const char * text, size_t size, const std::string &filename, CellLibrary &cells)
+{
+   const char * end = text + size;
+   //one cell a line at most, so counting the lines avoids growing the library
+   cells.reserve(cells.size() + std::count(text, end, '\n') + 1);
+   std::string name;
+   std::vector<Dimensions> options;
+   int line = 0;
+   const char * current = text;
+   while (current < end)
+   {
+      line++;
+      const char * lineEnd = (const char *)memchr(current, '\n', end - current);
+      if (!lineEnd)
+      {
+         lineEnd = end;
+      }
+      const char * tokenEnd;
+      const char * token = nextToken(current, lineEnd, tokenEnd);
+      current = lineEnd + 1;
+      //skip blank lines
+      if (token == tokenEnd)
+      {
+         continue;
+      }
+      name.assign(token, tokenEnd);
+      token = nextToken(tokenEnd, lineEnd, tokenEnd);
+      options.clear();
+      float area = 0;
+      float aspectRatio = 0;
+      bool fixed = false;
+      //fixed has an x in it, so it is a missing area rather than a list of shapes
+      if (!isFixed(token, tokenEnd) && (std::find(token, tokenEnd, 'x') != tokenEnd)) //a list of shapes
+      {
+         while ((token != tokenEnd) && !isFixed(token, tokenEnd))
+         {
+            const char * cross = std::find(token, tokenEnd, 'x');
+            Dimensions option;
+            if (!readNumber(token, cross, option.width, filename, line) || (cross == tokenEnd) ||
+                !readNumber(cross + 1, tokenEnd, option.height, filename, line))
+            {
+               cellError(filename, line, "shape is not of the form widthxheight");
+            }
+            if (!(option.width > 0) || !isfinite(option.width) || !(option.height > 0) || !isfinite(option.height))
+            {
+               cellError(filename, line, "width and height must be positive");
+            }
+            options.push_back(option);
+            token = nextToken(tokenEnd, lineEnd, tokenEnd);
+         }
+      }
+      else
+      {
+         if (!readNumber(token, tokenEnd, area, filename, line))
+         {
+            cellError(filename, line, "area is missing or not a number");
+         }
+         if (!(area > 0) || !isfinite(area))
+         {
+            cellError(filename, line, "area must be positive");
+         }
+         token = nextToken(tokenEnd, lineEnd, tokenEnd);
+         const char * colon = std::find(token, tokenEnd, ':');
+         if (colon != tokenEnd) //a range of aspect ratios
+         {
+            float minimum;
+            float maximum;
+            float count = 5;
+            const char * countColon = std::find(colon + 1, tokenEnd, ':');
+            if (!readNumber(token, colon, minimum, filename, line) || !readNumber(colon + 1, countColon, maximum, filename, line) ||
+                ((countColon != tokenEnd) && !readNumber(countColon + 1, tokenEnd, count, filename, line)))
+            {
+               cellError(filename, line, "aspect ratio range is not of the form min:max or min:max:count");
+            }
+            if (!(minimum > 0) || !(maximum >= minimum) || !isfinite(maximum) || !(count >= 1) || (count != floor(count)))
+            {
+               cellError(filename, line, "aspect ratio range must be positive and in order with a whole count");
+            }
+            if (count > maxAspectSamples)
+            {
+               cellError(filename, line, "aspect ratio range has too many samples");
+            }
+            for (int k = 0; k < (int)count; k++)
+            {
+               //spaced evenly by ratio, a single sample is the middle of the range
+               float t = (count > 1)? k / (count - 1) : 0.5f;
+               float ratio = minimum * pow(maximum / minimum, t);
+               //computed alike so a shape and its rotation within the range match
+               Dimensions option;
+               option.height = sqrt(area * ratio);
+               option.width = sqrt(area / ratio);
+               options.push_back(option);
+            }
+         }
+         else
+         {
+            if (!readNumber(token, tokenEnd, aspectRatio, filename, line))
+            {
+               cellError(filename, line, "aspect ratio is missing or not a number");
+            }
+            if (!(aspectRatio > 0) || !isfinite(aspectRatio))
+            {
+               cellError(filename, line, "aspect ratio must be positive");
+            }
+         }
+         token = nextToken(tokenEnd, lineEnd, tokenEnd);
+      }
+      if (isFixed(token, tokenEnd))
+      {
+         fixed = true;
+         token = nextToken(tokenEnd, lineEnd, tokenEnd);
+      }
+      if (token != tokenEnd)
+      {
+         cellError(filename, line, "unexpected text at the end of the line");
+      }
+      try
+      {
+         if (options.empty())
+         {
+            cells.add(SNode(name, area, aspectRatio, fixed));
+         }
+         else
+         {
+            cells.add(SNode(name, options, fixed));
+         }
+      }
+      catch (const char * message)
+      {
+         cellError(filename, line, message);
+      }
+   }
+}
+
+/***********************************************************************************
+ * Function: nextToken
+ * @brief finds the next field of a line
+ * @param current where to start looking
+ * @param end the end of the line
+ * @param tokenEnd set to the end of the field
+ * @return the start of the field, equal to tokenEnd if the line has no more
+************************************************************************************/
+const char * nextToken(const char * current, const char * end, const char * &tokenEnd)
+{
+   const char * token = skipBlanks(current, end);
+   tokenEnd = token;
+   while ((tokenEnd < end) && !isspace((unsigned char)*tokenEnd))
+   {
+      tokenEnd++;
+   }
+   return token;
+}
+
+/***********************************************************************************
+ * Function: readNumber
+ * @brief reads a number that must fill the whole of a piece of text, with an
+ *    optional leading + as the stream operators accept. A number too large or too
+ *    small for a float is reported as such rather than as not a number
+ * @param first the start of the text
+ * @param last the end of the text
+ * @param value set to the number
+ * @param filename the name of the file, used in error messages
+ * @param line the number of the line, used in error messages
+ * @return true if the text is exactly a number
+************************************************************************************/
+bool readNumber(const char * first, const char * last, float &value, const std::string &filename, int line)
+{
+   if ((first != last) && (*first == '+'))
+   {
+      first++;
+   }
+   std::from_chars_result result = std::from_chars(first, last, value);
+   if ((result.ec == std::errc::result_out_of_range) && (result.ptr == last))
+   {
+      cellError(filename, line, "number out of range");
+   }
+   return (first != last) && (result.ec == std::errc()) && (result.ptr == last);
+}
+
+/***********************************************************************************
+ * Function: isFixed
+ * @brief checks if a field is the keyword marking a cell that cannot be rotated
+ * @param first the start of the field
+ * @param last the end of the field
+ * @return true if the field is fixed
+************************************************************************************/
+bool isFixed(const char * first, const char * last)
+{
+   return (last - first == 5) && (memcmp(first, "fixed", 5) == 0);
+}
+
+/***********************************************************************************
+ * Function: skipBlanks
+ * @brief skips spaces, tabs and carriage returns
+ * @param current the first character to look at
+ * @param end the end of the line
+ * @return the first character that is not blank, or end
+************************************************************************************/
+const char * skipBlanks(const char * current, const char * end)
+{
+   while ((current < end) && isspace((unsigned char)*current))
+   {
+      current++;
+   }
+   return current;
+}
+
+/***********************************************************************************
+ * Function: getNets
+ * @brief loads the nets connecting the cells from the designated file, one net per
+ *    line given by the names of its cells
+ * @param filename the name of the file containing the nets
+ * @param cells the cells the names refer to
+ * @param nets the netlist to fill
+************************************************************************************/
+void getNets(std::string filename, const CellLibrary &cells, Netlist &nets)
+{
+   std::ifstream fin(filename);
+   if (fin.fail())
+   {
+      throw "Unable to open file";
+   }
+   std::string line;
+   std::vector<int32_t> net;
+   while(getline(fin,line))
+   {
+      std::stringstream stream(line);
+      std::string name;
+      net.clear();
+      while (stream >> name)
+      {
+         int32_t id = cells.findName(name);
+         if (id == -1) //item not found in cells
+         {
+            throw "Net data not valid!";
+         }
+         net.push_back(id);
+      }
+      //skip blank lines
+      if (!net.empty())
+      {
+         nets.addNet(net);
+      }
+   }
+   nets.finish(cells.size());
+}
+
+/***********************************************************************************
+ * Function: parseNPE
+ * @brief reads a Normalized Polish Expression written as text. Tokens are cell 
+ *    names, V or H separated by whitespace, or when there is no whitespace at all 
+ *    every character is a token
+ * @param text the Normalized Polish Expression as text
+ * @param cells the cells the names refer to
+ * @return the Normalized Polish Expression as tokens
+************************************************************************************/
+NPE parseNPE(const std::string &text, const CellLibrary &cells)
+{
+   NPE npe;
+   parseNPE(text, cells, npe);
+   return npe;
+}
+
+/***********************************************************************************
+ * Function: parseNPE
+ * @brief reads a Normalized Polish Expression written as text into an existing 
+ *    expression, reusing its memory and that of the token so reading many 
+ *    expressions does not allocate for each one
+ * @param text the Normalized Polish Expression as text
+ * @param cells the cells the names refer to
+ * @param npe the expression the tokens are written to, its contents are replaced
+************************************************************************************/
+void parseNPE(const std::string &text, const CellLibrary &cells, NPE &npe)
+{
+   static thread_local std::string token;
+   bool separated = (text.find_first_of(" \t") != std::string::npos);
+   npe.clear();
+   size_t position = 0;
+   while (position < text.size())
+   {
+      if (separated)
+      {
+         if (isspace((unsigned char)text[position]))
+         {
+            position++;
+            continue;
+         }
+         size_t end = position;
+         while ((end < text.size()) && !isspace((unsigned char)text[end]))
+         {
+            end++;
+         }
+         token.assign(text, position, end - position);
+         position = end;
+      }
+      else
+      {
+         token.assign(1, text[position++]);
+      }
+      if (token == "V")
+      {
+         npe.push_back(verticalCut);
+      }
+      else if (token == "H")
+      {
+         npe.push_back(horizontalCut);
+      }
+      else
+      {
+         int32_t id = cells.findName(token);
+         if (id == -1) //item not found in cells
+         {
+            throw "Cell data not valid!";
+         }
+         npe.push_back(id);
+      }
+   }
+}
+
+/***********************************************************************************
+ * Function: formatNPE
+ * @brief writes a Normalized Polish Expression as text, leaving out the spaces 
+ *    between tokens when every cell name is a single character
+ * @param npe the Normalized Polish Expression as tokens
+ * @param cells the cells the IDs refer to
+ * @return the Normalized Polish Expression as text
+************************************************************************************/
+std::string formatNPE(const NPE &npe, const CellLibrary &cells)
+{
+   std::string separator = cells.singleCharacterNames()? "" : " ";
+   std::string text;
+   for (int i = 0; i < (int)npe.size(); i++)
+   {
+      if (i > 0)
+      {
+         text += separator;
+      }
+      if (npe[i] == verticalCut)
+      {
+         text += 'V';
+      }
+      else if (npe[i] == horizontalCut)
+      {
+         text += 'H';
+      }
+      else
+      {
+         text += cells.cells[npe[i]].name;
+      }
+   }
+   return text;
+}
+
+/***********************************************************************************
+ * Function: cost
+ * @brief calculates the cost of the Normalized Polish expression given the cells
+ *    provided
+ * @param npe the Normalized Polish expression
+ * @param cells the cells to be arranged
+ * @return the area of the overall floorplan
+************************************************************************************/
+float cost(const NPE &npe ,const CellLibrary &cells)
+{
+   //every thread reuses its own context so trees of the same size never allocate
+   static thread_local EvalContext context;
+   return cost(npe, cells, context);
+}
+
+/***********************************************************************************
+ * Function: cost
+ * @brief calculates the cost of the Normalized Polish expression given the cells
+ *    provided, with the trees of the calling thread. Any number of threads can 
+ *    share the cells as long as each passes its own context
+ * @param npe the Normalized Polish expression
+ * @param cells the cells to be arranged
+ * @param context the trees to build, the memory of their previous contents is reused
+ * @param trusted skips validating an expression already known to be valid
+ * @return the area of the overall floorplan
+************************************************************************************/
+float cost(const NPE &npe ,const CellLibrary &cells, EvalContext &context, bool trusted)
+{
+   if (SNode::mergeMode == SNode::REFERENCE)
+   {
+      return generateTree(npe, cells, context.nodes, trusted)->calcMinArea();
+   }
+   context.tree.build(npe, cells, trusted);
+   return context.tree.evaluate();
+}
+
+/***********************************************************************************
+ * Function: cost
+ * @brief calculates the cost of the Normalized Polish expression given the cells
+ *    provided, building the tree out of the provided arena
+ * @param npe the Normalized Polish expression
+ * @param cells the cells to be arranged
+ * @param operators the arena the nodes of the tree are taken from
+ * @return the area of the overall floorplan
+************************************************************************************/
+float cost(const NPE &npe ,const CellLibrary &cells, NodeArena &operators)
+{
+   //create tree from npe
+   SNode * root = generateTree(npe, cells, operators);
+   return root->calcMinArea();
+}
+
+/***********************************************************************************
+ * Function: cost
+ * @brief calculates the cost of the Normalized Polish expression given the cells
+ *    provided with a flat slicing tree, evaluated in one forward sweep without 
+ *    recursion so any depth of tree can be handled
+ * @param npe the Normalized Polish expression
+ * @param cells the cells to be arranged
+ * @param tree the tree to build, the memory of its previous contents is reused
+ * @return the area of the overall floorplan
+************************************************************************************/
+float cost(const NPE &npe ,const CellLibrary &cells, SlicingTree &tree)
+{
+   tree.build(npe, cells);
+   return tree.evaluate();
+}
+
+/***********************************************************************************
+ * Function: generateTree
+ * @brief generates a slicing tree from a Normalized Polar Expression 
+ * @param npe the Normalized Polar Expression
+ * @param cells the cells to be organized
+ * @param operators the arena the nodes of the tree are taken from, any tree
+ *    previously built from it is released. Cells are copied into it so the 
+ *    library is never written to
+ * @param trusted skips validating an expression known to be valid, such as one 
+ *    produced by the moves of the annealer
+ * @return returns a pointer to the root of the tree which is also the first 
+ *    node of the arena
+************************************************************************************/
+SNode * generateTree(const NPE &npe, const CellLibrary &cells, NodeArena &operators, bool trusted)
+{
+   COUNTER_INCREMENT(generateTreeCalls);
+   //Validate npe
+   if(!trusted && !isValidNPE(npe, cells.size()))
+   {
+      std::cout << "Invalid NPE!";
+      throw "Invalid NPE!";
+   }
+   //every element of the npe becomes a node of the arena
+   operators.reset(npe.size());
+   //generate tree
+   NPE::const_reverse_iterator currentChar = npe.rbegin(); //start from back of npe
+   SNode * current = operators.allocate(*currentChar); //since it is npe we know this will be an operator
+   currentChar++;
+   while (currentChar != npe.rend()) //while there are still characters in NPE
+   {
+      if(isOperator(*currentChar)) //its an operator
+      {
+         SNode * node = operators.allocate(*currentChar);
+         if(current->right) //assign right when possible left if not
+         {
+            current->left = node;
+            current->left->parent = current;
+         }
+         else
+         {
+            current->right = node;
+            current->right->parent = current;
+         }
+         current = node;
+      }
+      else //its a operand
+      {
+         //find the opperand in the cells
+         const SNode * cell = cells.find(*currentChar);
+         //assign a copy to right if possible left otherwise
+         if(cell)
+         {
+            SNode * child = operators.allocate(*cell);
+            child->parent = current;
+            if(current->right) 
+            {
+               current->left = child;
+               while ((current != operators.root()) && (current->left))
+               {
+                  current = current->parent;
+               }
+            }
+            else
+            {
+               current->right = child;
+            }
+         }
+         else //item not found in cells 
+         {
+            throw "Cell data not valid!";
+         }
+      }
+      currentChar++;
+   }
+   return operators.root();
+}
+
+/***********************************************************************************
+ * Function: verticalNPE
+ * @brief builds a Normalized Polish Expression that slices every cell vertically 
+ *    in the order they were loaded, used as a starting point for annealing
+ * @param cells the cells to be arranged
+ * @return the Normalized Polish Expression as tokens
+************************************************************************************/
+NPE verticalNPE(const CellLibrary &cells)
+{
+   NPE npe;
+   for (int i = 0; i < cells.size(); i++)
+   {
+      npe.push_back(cells.cells[i].id);
+      if (i > 0)
+      {
+         npe.push_back(verticalCut);
+      }
+   }
+   return npe;
+}
+
+/***********************************************************************************
+ * Function: placeNPE
+ * @brief gives every cell of a Normalized Polish Expression its coordinates for 
+ *    the smallest size of the floorplan
+ * @param npe the Normalized Polish Expression
+ * @param cells the cells to be arranged
+ * @param pruning how far the sizes were thinned out when the expression was found
+ * @return the placement of every cell indexed by ID
+************************************************************************************/
+std::vector<Placement> placeNPE(const NPE &npe, const CellLibrary &cells, const CurvePruning &pruning)
+{
+   SlicingTree tree;
+   tree.setPruning(pruning);
+   tree.build(npe, cells);
+   std::vector<Placement> placements;
+   tree.place(placements);
+   return placements;
+}
+
+#endif
@@ -0,0 +1,109 @@
+/***********************************************************************************
+ * File: MappedFile.h
+ * @brief Contains the MappedFile class which maps a whole file into memory for
+ *    reading
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/***********************************************************************************
+ * Class: MappedFile
+ * @brief a read-only view of a file mapped into memory. The pages are read by the
+ *    operating system as they are touched, so parsing the contents makes no copy
+ *    of them and the file is not read through a stream. The mapping is released
+ *    when the object is destroyed
+************************************************************************************/
+class MappedFile
+{
+public:
+   MappedFile(const std::string &filename);
+   ~MappedFile();
+   const char * data() const;
+   size_t size() const;
+private:
+   const char * contents;
+   size_t length;
+   MappedFile(const MappedFile &);
+   MappedFile & operator= (const MappedFile &);
+};
+
+/***********************************************************************************
+ * Constructor: MappedFile
+ * @brief maps a file into memory
+ * @param filename the name of the file to map
+************************************************************************************/
+MappedFile::MappedFile(const std::string &filename)
+{
+   this->contents = NULL;
+   this->length = 0;
+   int descriptor = open(filename.c_str(), O_RDONLY);
+   if (descriptor < 0)
+   {
+      throw "Unable to open file";
+   }
+   struct stat status;
+   if (fstat(descriptor, &status) != 0)
+   {
+      close(descriptor);
+      throw "Unable to open file";
+   }
+   //an empty file cannot be mapped, it is left without contents
+   if (status.st_size > 0)
+   {
+      void * address = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (address == MAP_FAILED)
+      {
+         close(descriptor);
+         throw "Unable to open file";
+      }
+      //the file is read from front to back
+      madvise(address, status.st_size, MADV_SEQUENTIAL);
+      this->contents = (const char *)address;
+      this->length = status.st_size;
+   }
+   //the mapping stays valid once the descriptor is closed
+   close(descriptor);
+}
+
+/***********************************************************************************
+ * Destructor: MappedFile
+ * @brief releases the mapping
+************************************************************************************/
+MappedFile::~MappedFile()
+{
+   if (contents)
+   {
+      munmap((void *)contents, length);
+   }
+}
+
+/***********************************************************************************
+ * Function: data
+ * @brief gets the contents of the file
+ * @return a pointer to the first byte, NULL for an empty file
+************************************************************************************/
+const char * MappedFile::data() const
+{
+   return contents;
+}
+
+/***********************************************************************************
+ * Function: size
+ * @brief gets the size of the file
+ * @return the number of bytes
+************************************************************************************/
+size_t MappedFile::size() const
+{
+   return length;
+}
+
+#endif
@@ -0,0 +1,91 @@
+/***********************************************************************************
+ * File: NPE.h
+ * @brief Contains the token representation of a Normalized Polish Expression
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef NPE_H
+#define NPE_H
+
+#include <stdint.h>
+#include <vector>
+
+/***********************************************************************************
+ * Type: NPE
+ * @brief a Normalized Polish Expression as a list of tokens. A token that is zero
+ *    or more is the ID of a cell, a negative token is an operator
+************************************************************************************/
+typedef std::vector<int32_t> NPE;
+
+const int32_t verticalCut = -1;   //the V operator
+const int32_t horizontalCut = -2; //the H operator
+
+const uint64_t hashBase = 0x100000001b3ULL; //odd multiplier of the rolling hashes
+
+bool isOperator(int32_t token);
+int32_t complement(int32_t cut);
+uint64_t mixHash(uint64_t value);
+uint64_t tokenHash(int32_t token);
+uint64_t positionHash(int position, int32_t token);
+
+/***********************************************************************************
+ * Function: isOperator
+ * @brief checks if a token is an operator
+ * @param token the token to check
+ * @return true if it is an operator false if it is a cell
+************************************************************************************/
+bool isOperator(int32_t token)
+{
+   return token < 0;
+}
+
+/***********************************************************************************
+ * Function: complement
+ * @brief gets the other operator (V becomes H and H becomes V)
+ * @param cut the operator to complement
+ * @return the complemented operator
+************************************************************************************/
+int32_t complement(int32_t cut)
+{
+   return (cut == verticalCut)? horizontalCut : verticalCut;
+}
+
+/***********************************************************************************
+ * Function: mixHash
+ * @brief scrambles a value into a well mixed 64 bit value (splitmix64)
+ * @param value the value to scramble
+ * @return the scrambled value
+************************************************************************************/
+uint64_t mixHash(uint64_t value)
+{
+   uint64_t z = value + 0x9e3779b97f4a7c15ULL;
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+   return z ^ (z >> 31);
+}
+
+/***********************************************************************************
+ * Function: tokenHash
+ * @brief gets the digit of a token in the rolling hash of an expression
+ * @param token the token to hash
+ * @return the hash of the token
+************************************************************************************/
+uint64_t tokenHash(int32_t token)
+{
+   return mixHash((uint64_t)(int64_t)token);
+}
+
+/***********************************************************************************
+ * Function: positionHash
+ * @brief gets the Zobrist key of a token at a position, computed rather than kept
+ *    in a table so any number of cells and positions can be hashed
+ * @param position the position of the token in the expression
+ * @param token the token
+ * @return the key XORed into the hash of an expression holding the token there
+************************************************************************************/
+uint64_t positionHash(int position, int32_t token)
+{
+   return mixHash(tokenHash(token) ^ ((uint64_t)position * 0xd6e8feb86659fd93ULL));
+}
+
+#endif
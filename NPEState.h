@@ -0,0 +1,208 @@
+/***********************************************************************************
+ * File: NPEState.h
+ * @brief Contains the NPEState class which keeps a Normalized Polish Expression
+ *    together with what is needed to check moves on it in constant time
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef NPESTATE_H
+#define NPESTATE_H
+
+#include <vector>
+#include <algorithm>
+#include "NPE.h"
+
+/***********************************************************************************
+ * Class: NPEState
+ * @brief a Normalized Polish Expression along with the number of operators in
+ *    every prefix of it. Swapping an adjacent operand and operator (M3) only
+ *    changes the count of the prefix ending between them, so whether the swap keeps
+ *    the balloting property can be checked and the counts updated in constant time.
+ *    The position of every operand in order is kept as well: M1 and M2 leave every
+ *    position holding an operand as it was and M3 moves one operand a step without
+ *    passing another, so the k-th operand is found in constant time. It also keeps
+ *    a Zobrist hash of the expression, the XOR of the keys of every token at its
+ *    position, which a move updates by XORing out the keys of the tokens it 
+ *    replaces and XORing in the new ones
+************************************************************************************/
+class NPEState
+{
+public:
+   void assign(const NPE &npe);
+   void swapOperands(int i, int j);
+   void complement(int i);
+   bool canSwapOperandOperator(int i) const;
+   void swapOperandOperator(int i);
+   int size() const;
+   int operandCount() const;
+   int operandPosition(int k) const;
+   uint64_t getHash() const;
+   const NPE & getNPE() const;
+private:
+   NPE npe;
+   std::vector<int> operators; //the number of operators in npe[0..i]
+   std::vector<int> operands;  //the position of the k-th operand
+   uint64_t hash;
+   void swapTokens(int i, int j);
+};
+
+/***********************************************************************************
+ * Function: assign
+ * @brief replaces the expression and counts its operators
+ * @param npe the Normalized Polish Expression, assumed to be valid
+************************************************************************************/
+void NPEState::assign(const NPE &npe)
+{
+   this->npe = npe;
+   operators.resize(npe.size());
+   operands.clear();
+   hash = 0;
+   int count = 0;
+   for (int i = 0; i < (int)npe.size(); i++)
+   {
+      if (isOperator(npe[i]))
+      {
+         count++;
+      }
+      else
+      {
+         operands.push_back(i);
+      }
+      operators[i] = count;
+      hash ^= positionHash(i, npe[i]);
+   }
+}
+
+/***********************************************************************************
+ * Function: swapOperands
+ * @brief swaps two operands (the M1 move), no count changes
+ * @param i the position of the first operand
+ * @param j the position of the second operand
+************************************************************************************/
+void NPEState::swapOperands(int i, int j)
+{
+   swapTokens(i, j);
+}
+
+/***********************************************************************************
+ * Function: complement
+ * @brief complements one operator (part of the M2 move), no count changes
+ * @param i the position of the operator
+************************************************************************************/
+void NPEState::complement(int i)
+{
+   hash ^= positionHash(i, npe[i]);
+   npe[i] = ::complement(npe[i]);
+   hash ^= positionHash(i, npe[i]);
+}
+
+/***********************************************************************************
+ * Function: canSwapOperandOperator
+ * @brief checks in constant time if swapping the elements at i and i+1 leaves a
+ *    valid Normalized Polish Expression. Only the prefix ending at i changes, so
+ *    moving the operator left has to keep more operands than operators in it, and
+ *    either way the operator must not end up next to an equal one
+ * @param i the position of the first element of the pair
+ * @return true if the pair is an operand and an operator that can be swapped
+************************************************************************************/
+bool NPEState::canSwapOperandOperator(int i) const
+{
+   if ((i < 0) || (i + 1 >= (int)npe.size()) || (isOperator(npe[i]) == isOperator(npe[i + 1])))
+   {
+      return false;
+   }
+   if (isOperator(npe[i + 1]))
+   {
+      //operand then operator: the operator moves left into the prefix ending at i
+      int cut = npe[i + 1];
+      if (2 * (operators[i] + 1) >= i + 1)
+      {
+         return false;
+      }
+      return (i == 0) || (npe[i - 1] != cut);
+   }
+   //operator then operand: the operator moves right, next to the element after it
+   int cut = npe[i];
+   return (i + 2 == (int)npe.size()) || (npe[i + 2] != cut);
+}
+
+/***********************************************************************************
+ * Function: swapOperandOperator
+ * @brief swaps the adjacent operand and operator at i and i+1 (the M3 move)
+ * @param i the position of the first element of the pair
+************************************************************************************/
+void NPEState::swapOperandOperator(int i)
+{
+   swapTokens(i, i + 1);
+   operators[i] += isOperator(npe[i])? 1 : -1;
+   //the operands before position p number p - operators[p] when p holds an operand
+   int p = isOperator(npe[i])? i + 1 : i;
+   operands[p - operators[p]] = p;
+}
+
+/***********************************************************************************
+ * Function: size
+ * @brief gets the number of elements of the expression
+ * @return the number of elements
+************************************************************************************/
+int NPEState::size() const
+{
+   return npe.size();
+}
+
+/***********************************************************************************
+ * Function: operandCount
+ * @brief gets the number of operands of the expression
+ * @return the number of operands
+************************************************************************************/
+int NPEState::operandCount() const
+{
+   return operands.size();
+}
+
+/***********************************************************************************
+ * Function: operandPosition
+ * @brief finds an operand by its order in the expression
+ * @param k the order of the operand, from 0
+ * @return the position of the k-th operand
+************************************************************************************/
+int NPEState::operandPosition(int k) const
+{
+   return operands[k];
+}
+
+/***********************************************************************************
+ * Function: getHash
+ * @brief gets the Zobrist hash of the expression, equal for equal expressions 
+ *    however they were reached
+ * @return the hash
+************************************************************************************/
+uint64_t NPEState::getHash() const
+{
+   return hash;
+}
+
+/***********************************************************************************
+ * Function: swapTokens
+ * @brief swaps two tokens, updating the hash with the four keys involved
+ * @param i the position of the first token
+ * @param j the position of the second token
+************************************************************************************/
+void NPEState::swapTokens(int i, int j)
+{
+   hash ^= positionHash(i, npe[i]) ^ positionHash(j, npe[j]);
+   std::swap(npe[i], npe[j]);
+   hash ^= positionHash(i, npe[i]) ^ positionHash(j, npe[j]);
+}
+
+/***********************************************************************************
+ * Function: getNPE
+ * @brief gets the expression
+ * @return the Normalized Polish Expression as tokens
+************************************************************************************/
+const NPE & NPEState::getNPE() const
+{
+   return npe;
+}
+
+#endif
@@ -0,0 +1,117 @@
+/***********************************************************************************
+ * File: NodeArena.h
+ * @brief Contains the NodeArena class which provides the nodes of a slicing tree
+ *    without allocating them for every tree
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef NODEARENA_H
+#define NODEARENA_H
+
+#include <vector>
+#include "SNode.h"
+
+/***********************************************************************************
+ * Class: NodeArena
+ * @brief pool of nodes that is reused from one tree to the next. A Normalized 
+ *    Polish Expression has one node per element, so the pool is sized once and the
+ *    nodes (along with the memory of their names and sizes) are handed out again by
+ *    every following tree of the same size. Cells are copied in rather than linked
+ *    from the library, so a tree never writes to anything shared
+************************************************************************************/
+class NodeArena
+{
+public:
+   NodeArena();
+   void reset(int size);
+   SNode * allocate(int32_t cut);
+   SNode * allocate(const SNode &cell);
+   SNode * root();
+private:
+   std::vector<SNode> nodes;
+   int used;
+};
+
+/***********************************************************************************
+ * Constructor: NodeArena
+ * @brief constructs an empty arena
+************************************************************************************/
+NodeArena::NodeArena()
+{
+   this->used = 0;
+}
+
+/***********************************************************************************
+ * Function: reset
+ * @brief releases every node for the next tree, growing the pool if needed
+ * @param size the number of nodes the next tree will have
+************************************************************************************/
+void NodeArena::reset(int size)
+{
+   if ((int)nodes.size() < size)
+   {
+      nodes.resize(size, SNode(verticalCut));
+   }
+   used = 0;
+}
+
+/***********************************************************************************
+ * Function: allocate
+ * @brief hands out the next operator node
+ * @param cut should be verticalCut or horizontalCut
+ * @return a pointer to the unlinked operator node
+************************************************************************************/
+SNode * NodeArena::allocate(int32_t cut)
+{
+   if (used == (int)nodes.size())
+   {
+      throw "Node arena is full!";
+   }
+   SNode * node = &nodes[used++];
+   //the node may have held a cell in an earlier tree
+   node->isOperator = true;
+   node->fixed = true; //operators are always fixed
+   node->id = cut;
+   node->name = (cut == verticalCut)? "V" : "H";
+   node->area = 0;
+   node->aspectRatio = 0;
+   node->right = NULL;
+   node->left = NULL;
+   node->parent = NULL;
+   //clearing keeps the memory of the sizes for reuse
+   node->sizes.clear();
+   return node;
+}
+
+/***********************************************************************************
+ * Function: allocate
+ * @brief hands out the next node as a copy of a cell
+ * @param cell the cell to copy
+ * @return a pointer to the unlinked copy
+************************************************************************************/
+SNode * NodeArena::allocate(const SNode &cell)
+{
+   if (used == (int)nodes.size())
+   {
+      throw "Node arena is full!";
+   }
+   SNode * node = &nodes[used++];
+   //assigning keeps the memory of the name and the sizes for reuse
+   *node = cell;
+   node->right = NULL;
+   node->left = NULL;
+   node->parent = NULL;
+   return node;
+}
+
+/***********************************************************************************
+ * Function: root
+ * @brief gets the first node handed out since the last reset
+ * @return a pointer to the first node
+************************************************************************************/
+SNode * NodeArena::root()
+{
+   return &nodes[0];
+}
+
+#endif
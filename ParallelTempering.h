@@ -0,0 +1,229 @@
+/***********************************************************************************
+ * File: ParallelTempering.h
+ * @brief Contains the ParallelTempering class which runs several annealing chains
+ *    at fixed temperatures on separate threads and exchanges them between
+ *    neighbouring temperatures
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef PARALLELTEMPERING_H
+#define PARALLELTEMPERING_H
+
+#include <math.h>
+#include <vector>
+#include <random>
+#include <thread>
+#include "NPE.h"
+#include "CellLibrary.h"
+#include "Annealer.h"
+
+/***********************************************************************************
+ * Struct: TemperingSchedule
+ * @brief Contains the parameters of a parallel tempering run. From the annealing
+ *    schedule initialTemperature is the hottest temperature (sampled if <= 0),
+ *    freezeRatio gives the coldest, movesPerCell is the number of moves between
+ *    exchanges and seed is the seed of the first chain. cacheBytes is the memory
+ *    of the whole run, split evenly between the caches of the chains
+************************************************************************************/
+struct TemperingSchedule
+{
+   int chains;                  //number of chains, each at its own temperature
+   int threads;                 //threads running the chains, 0 for every hardware thread
+   int rounds;                  //number of times the chains are run and then exchanged
+   AnnealingSchedule annealing;
+   TemperingSchedule();
+};
+
+/***********************************************************************************
+ * Class: ParallelTempering
+ * @brief runs one Annealer per temperature of a geometric ladder. Every chain has
+ *    its own slicing tree and its own generator seeded from its index, and the
+ *    exchanges are decided on the calling thread, so the result depends only on
+ *    the schedule and never on the number of threads. Exchanging the
+ *    configurations of two neighbouring temperatures is done by exchanging which
+ *    temperature each chain runs at, so no tree has to be copied
+************************************************************************************/
+class ParallelTempering
+{
+public:
+   NPE bestNPE; //the best Normalized Polish Expression found by any chain
+   float bestCost;
+   float bestError; //how much larger than exact bestCost may be because of pruning
+   ParallelTempering(const CellLibrary &cells, const NPE &npe, const TemperingSchedule &schedule, const Netlist *nets = NULL);
+   ~ParallelTempering();
+   float run();
+private:
+   const CellLibrary &cells;
+   TemperingSchedule schedule;
+   std::mt19937 random;
+   std::vector<Annealer *> chains;
+   std::vector<float> temperatures; //the ladder from coldest to hottest
+   std::vector<int> chainAt;        //the chain running at every temperature
+   void runChains(int thread, int threads, int moves);
+   void exchange(int first);
+   void updateBest();
+};
+
+/***********************************************************************************
+ * Constructor: TemperingSchedule
+ * @brief constructs the default parallel tempering schedule
+************************************************************************************/
+TemperingSchedule::TemperingSchedule()
+{
+   this->chains = 8;
+   this->threads = 0;
+   this->rounds = 200;
+}
+
+/***********************************************************************************
+ * Constructor: ParallelTempering
+ * @brief constructs every chain starting from the provided expression
+ * @param cells the cells to be arranged
+ * @param npe the Normalized Polish Expression every chain starts from
+ * @param schedule the parameters of the run
+ * @param nets the nets connecting the cells, shared by every chain, or NULL to 
+ *    only count area
+************************************************************************************/
+ParallelTempering::ParallelTempering(const CellLibrary &cells, const NPE &npe, const TemperingSchedule &schedule, const Netlist *nets)
+   : cells(cells), schedule(schedule), random(schedule.annealing.seed)
+{
+   if (this->schedule.chains < 1)
+   {
+      this->schedule.chains = 1;
+   }
+   for (int k = 0; k < this->schedule.chains; k++)
+   {
+      AnnealingSchedule chainSchedule = schedule.annealing;
+      chainSchedule.seed = schedule.annealing.seed + k;
+      //every chain has its own cache, so they share out the memory of the run
+      chainSchedule.cacheBytes = schedule.annealing.cacheBytes / this->schedule.chains;
+      chains.push_back(new Annealer(cells, npe, chainSchedule, nets));
+      chainAt.push_back(k);
+   }
+   this->bestNPE = npe;
+   this->bestCost = chains[0]->currentCost;
+   this->bestError = chains[0]->bestError;
+}
+
+/***********************************************************************************
+ * Destructor: ParallelTempering
+ * @brief releases the chains
+************************************************************************************/
+ParallelTempering::~ParallelTempering()
+{
+   for (int k = 0; k < (int)chains.size(); k++)
+   {
+      delete chains[k];
+   }
+}
+
+/***********************************************************************************
+ * Function: run
+ * @brief runs every chain for the scheduled number of rounds, exchanging
+ *    neighbouring temperatures after each round
+ * @return the best cost found
+************************************************************************************/
+float ParallelTempering::run()
+{
+   //a single cell has nothing to rearrange
+   if (cells.size() < 2)
+   {
+      return bestCost;
+   }
+   //geometric ladder from the freezing temperature up to the hottest one
+   float hottest = schedule.annealing.initialTemperature;
+   if (hottest <= 0)
+   {
+      hottest = chains[0]->initialTemperature();
+   }
+   int count = chains.size();
+   temperatures.resize(count);
+   for (int s = 0; s < count; s++)
+   {
+      float fraction = (count == 1)? 1 : (float)s / (count - 1);
+      temperatures[s] = hottest * pow(schedule.annealing.freezeRatio, 1 - fraction);
+   }
+   int threads = schedule.threads;
+   if (threads <= 0)
+   {
+      threads = std::thread::hardware_concurrency();
+   }
+   threads = std::max(1, std::min(threads, count));
+   int moves = schedule.annealing.movesPerCell * cells.size();
+   for (int round = 0; round < schedule.rounds; round++)
+   {
+      std::vector<std::thread> workers;
+      for (int t = 1; t < threads; t++)
+      {
+         workers.push_back(std::thread(&ParallelTempering::runChains, this, t, threads, moves));
+      }
+      runChains(0, threads, moves);
+      for (int t = 0; t < (int)workers.size(); t++)
+      {
+         workers[t].join();
+      }
+      //alternate between the even and the odd pairs of neighbours
+      exchange(round % 2);
+   }
+   updateBest();
+   return bestCost;
+}
+
+/***********************************************************************************
+ * Function: runChains
+ * @brief runs the share of the chains belonging to one thread for one round
+ * @param thread the index of the thread
+ * @param threads the number of threads
+ * @param moves the number of moves each chain attempts
+************************************************************************************/
+void ParallelTempering::runChains(int thread, int threads, int moves)
+{
+   for (int s = thread; s < (int)chainAt.size(); s += threads)
+   {
+      Annealer * chain = chains[chainAt[s]];
+      for (int i = 0; i < moves; i++)
+      {
+         chain->step(temperatures[s]);
+      }
+   }
+}
+
+/***********************************************************************************
+ * Function: exchange
+ * @brief offers every other pair of neighbouring temperatures an exchange of their
+ *    chains, accepted with probability min(1, exp((1/Ti - 1/Tj)(Ci - Cj)))
+ * @param first the lower temperature of the first pair, 0 or 1
+************************************************************************************/
+void ParallelTempering::exchange(int first)
+{
+   std::uniform_real_distribution<float> uniform(0, 1);
+   for (int s = first; s + 1 < (int)chainAt.size(); s += 2)
+   {
+      float colder = chains[chainAt[s]]->currentCost;
+      float hotter = chains[chainAt[s + 1]]->currentCost;
+      float exponent = (1 / temperatures[s] - 1 / temperatures[s + 1]) * (colder - hotter);
+      if ((exponent >= 0) || (uniform(random) < exp(exponent)))
+      {
+         std::swap(chainAt[s], chainAt[s + 1]);
+      }
+   }
+}
+
+/***********************************************************************************
+ * Function: updateBest
+ * @brief collects the best solution found by any chain
+************************************************************************************/
+void ParallelTempering::updateBest()
+{
+   for (int k = 0; k < (int)chains.size(); k++)
+   {
+      if (chains[k]->bestCost < bestCost)
+      {
+         bestCost = chains[k]->bestCost;
+         bestNPE = chains[k]->bestNPE;
+         bestError = chains[k]->bestError;
+      }
+   }
+}
+
+#endif
@@ -8,21 +8,12 @@
 #define SNODE_H
 
 #include <math.h>
-#include <list>
-
-/***********************************************************************************
- * Struct: Dimensions
- * @brief Contains the dimensions of the cell (height and width)
-************************************************************************************/
-struct Dimensions
-{
-   float height;
-   float width;
-   std::list<Dimensions>::iterator rSelected;
-   std::list<Dimensions>::iterator lSelected;
-};
-
-bool operator== (const Dimensions &lhs, const Dimensions &rhs);
+#include <ostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include "NPE.h"
+#include "ShapeCurve.h"
 
 /***********************************************************************************
  * Class: SNode
@@ -31,25 +22,38 @@ bool operator== (const Dimensions &lhs, const Dimensions &rhs);
 class SNode 
 {
 public:
+   // how operators combine the sizes of their children
+   enum MergeMode
+   {
+      STOCKMEYER, // linear merge of the width sorted sizes, the default
+      REFERENCE   // every pair of sizes filtered by addToDimensions, for validation
+   };
+   static MergeMode mergeMode;
    bool isOperator;
    bool fixed;
-   char name;
+   int32_t id;       //the cell ID, or verticalCut or horizontalCut for an operator
+   std::string name;
    float aspectRatio;
    float area;
-   std::list<Dimensions> sizes;
+   ShapeCurve sizes;
    Dimensions selected;
    SNode * right;
    SNode * left;
    SNode * parent;
-   SNode(char name, float area, float aspectRatio);
-   SNode(char name, float area, float aspectRatio, bool fixed);
-   SNode(char name);
-   float calcMinArea();
+   SNode(const std::string &name, float area, float aspectRatio);
+   SNode(const std::string &name, float area, float aspectRatio, bool fixed);
+   SNode(const std::string &name, const std::vector<Dimensions> &options, bool fixed);
+   SNode(const std::string &name, float area, float aspectRatio, bool fixed, ShapeCurve sizes);
+   SNode(int32_t cut);
+   float calcMinArea(float cutoff = INFINITY);
+   float combineChildren();
+   bool addToDimensions(Dimensions &nDimension);
 private:
    void calcWandH ();
-   bool addToDimensions(Dimensions &nDimension);
 };
 
+SNode::MergeMode SNode::mergeMode = SNode::STOCKMEYER;
+
 /***********************************************************************************
  * Constructor: SNode
  * @brief constructs a cell item for a operand
@@ -57,11 +61,12 @@ private:
  * @param area the area of the cell
  * @param aspectRatio the aspect ratio of the cell
 ************************************************************************************/
-SNode::SNode(char name, float area, float aspectRatio)
+SNode::SNode(const std::string &name, float area, float aspectRatio)
 {
    // define the normal data
    this->isOperator = false;
    this->fixed = false;
+   this->id = 0; //assigned when the cell is added to a library
    this->name = name;
    this->area = area;
    this->aspectRatio = aspectRatio;
@@ -80,11 +85,12 @@ SNode::SNode(char name, float area, float aspectRatio)
  * @param area the area of the cell
  * @param aspectRatio the aspect ratio of the cell
 ************************************************************************************/
-SNode::SNode(char name, float area, float aspectRatio, bool fixed)
+SNode::SNode(const std::string &name, float area, float aspectRatio, bool fixed)
 {
    // define the normal data
    this->isOperator = false;
    this->fixed = fixed;
+   this->id = 0; //assigned when the cell is added to a library
    this->name = name;
    this->area = area;
    this->aspectRatio = aspectRatio;
@@ -96,20 +102,89 @@ SNode::SNode(char name, float area, float aspectRatio, bool fixed)
    this->parent = NULL;
 }
 
+/***********************************************************************************
+ * Constructor: SNode
+ * @brief constructs a cell item for a operand that can take any of several shapes,
+ *    each also rotated unless the cell is fixed. Shapes that another one beats in
+ *    both width and height are dropped, and the area and aspect ratio are those 
+ *    of the smallest shape
+ * @param name the name of the cell
+ * @param options the width and height of every shape, must not be empty
+ * @param fixed true if the cell cannot be rotated
+************************************************************************************/
+SNode::SNode(const std::string &name, const std::vector<Dimensions> &options, bool fixed)
+{
+   // define the normal data
+   this->isOperator = false;
+   this->fixed = fixed;
+   this->id = 0; //assigned when the cell is added to a library
+   this->name = name;
+   sizes.reserve(fixed? options.size() : 2 * options.size());
+   for (uint32_t o = 0; o < options.size(); o++)
+   {
+      //for a cell the indices name the option and whether it is rotated
+      Dimensions size = options[o];
+      size.rSelected = o;
+      size.lSelected = 0;
+      addToDimensions(size);
+      if ((!fixed) && (size.height != size.width))
+      {
+         std::swap(size.height, size.width);
+         size.lSelected = 1;
+         addToDimensions(size);
+      }
+   }
+   selected = sizes[minAreaIndex(sizes)];
+   this->area = selected.height * selected.width;
+   this->aspectRatio = selected.height / selected.width;
+   //wont have a right and left child so will be null
+   this->right = NULL;
+   this->left = NULL;
+   this->parent = NULL;
+}
+
+/***********************************************************************************
+ * Constructor: SNode
+ * @brief constructs a cell item for a operand whose sizes are already known, such
+ *    as one read back from a binary design, without calculating them again
+ * @param name the name of the cell
+ * @param area the area of the cell
+ * @param aspectRatio the aspect ratio of the cell
+ * @param fixed true if the cell cannot be rotated
+ * @param sizes the sizes of the cell, sorted by width and none beaten by another
+************************************************************************************/
+SNode::SNode(const std::string &name, float area, float aspectRatio, bool fixed, ShapeCurve sizes)
+{
+   // define the normal data
+   this->isOperator = false;
+   this->fixed = fixed;
+   this->id = 0; //assigned when the cell is added to a library
+   this->name = name;
+   this->area = area;
+   this->aspectRatio = aspectRatio;
+   this->sizes = std::move(sizes);
+   //wont have a right and left child so will be null
+   this->right = NULL;
+   this->left = NULL;
+   this->parent = NULL;
+}
+
 /***********************************************************************************
  * Constructor: SNode
  * @brief constructs a operator cell 
- * @param name should be a 'V' or 'H' for vertical and horizontal cuts respectively
+ * @param cut should be verticalCut or horizontalCut
 ************************************************************************************/
-SNode::SNode(char name)
+SNode::SNode(int32_t cut)
 {
    //define the operator 
    this->isOperator = true;
    this->fixed = true; //operators are always fixed
-   this->name = name;
+   this->id = cut;
+   this->name = (cut == verticalCut)? "V" : "H";
    // default everything else to zero or null
    this->area = 0;
    this->aspectRatio = 0;
+   this->selected = Dimensions();
    this->right = NULL;
    this->left = NULL;
    this->parent = NULL;
@@ -118,73 +193,90 @@ SNode::SNode(char name)
 /***********************************************************************************
  * Function: calcMinArea
  * @brief gets the area of the cell (or group of cells if it is an operator) also 
- *    defines size.height, size.width, and aspectRatio for operators
- * @return the area of the cell (or group) as a float
+ *    defines size.height, size.width, and aspectRatio for operators. A group is
+ *    never smaller than any group inside it, so once one passes the cutoff the
+ *    rest is not calculated
+ * @param cutoff the area above which the exact result is not needed
+ * @return the area of the cell (or group) as a float, or INFINITY if it is above
+ *    the cutoff
 ************************************************************************************/
-float SNode::calcMinArea()
+float SNode::calcMinArea(float cutoff)
 {
    if(isOperator)
    {
-      //make sure sizes is currently empty
-      sizes.clear();
       // if right or left child is operator calc their values
-      if(right->isOperator)
+      if(right->isOperator && (right->calcMinArea(cutoff) == INFINITY))
       {
-         right->calcMinArea();
+         return INFINITY;
       }
-      if(left->isOperator)
+      if(left->isOperator && (left->calcMinArea(cutoff) == INFINITY))
       {
-         left->calcMinArea();
+         return INFINITY;
       }
-      // if this is a vertical slice do corresponding calculation
-      // otherwise do calculation for horizontal slice 
-      if (name == 'V')
-      {
-         for (std::list<Dimensions>::iterator i = right->sizes.begin(); i != right->sizes.end(); i++)
-         {
-            for (std::list<Dimensions>::iterator j = left->sizes.begin(); j != left->sizes.end(); j++)
-            {
-               Dimensions nSize;
-               nSize.width = i->width + j->width;
-               nSize.height = (i->height >= j->height)? i->height : j->height;
-               nSize.rSelected = i;
-               nSize.lSelected = j;
-               addToDimensions(nSize);
-            }
-         }
-      }
-      else //it is a horizontal slice
+      combineChildren();
+   }
+   if (area > cutoff)
+   {
+      return INFINITY;
+   }
+   return area;
+}
+
+/***********************************************************************************
+ * Function: combineChildren
+ * @brief recalculates the sizes of an operator from the current sizes of its 
+ *    children without recalculating the children themselves
+ * @return the area of the group as a float
+************************************************************************************/
+float SNode::combineChildren()
+{
+   COUNTER_INCREMENT(nodeVisits);
+   //make sure sizes is currently empty
+   sizes.clear();
+   if (mergeMode == STOCKMEYER)
+   {
+      mergeCurves(id, left->sizes, right->sizes, sizes);
+   }
+   // if this is a vertical slice do corresponding calculation
+   // otherwise do calculation for horizontal slice 
+   else if (id == verticalCut)
+   {
+      COUNTER_ADD(candidatePairs, right->sizes.size() * left->sizes.size());
+      for (uint32_t i = 0; i < right->sizes.size(); i++)
       {
-         for (std::list<Dimensions>::iterator i = right->sizes.begin(); i != right->sizes.end(); i++)
+         for (uint32_t j = 0; j < left->sizes.size(); j++)
          {
-            for (std::list<Dimensions>::iterator j = left->sizes.begin(); j != left->sizes.end(); j++)
-            {
-               Dimensions nSize;
-               nSize.width = (i->width >= j->width)? i->width : j->width;
-               nSize.height = i->height + j->height;
-               nSize.rSelected = i;
-               nSize.lSelected = j;
-               addToDimensions(nSize);
-            }
+            Dimensions nSize;
+            nSize.width = right->sizes.width[i] + left->sizes.width[j];
+            nSize.height = std::max(right->sizes.height[i], left->sizes.height[j]);
+            nSize.rSelected = i;
+            nSize.lSelected = j;
+            addToDimensions(nSize);
          }
       }
-
-      //Calculate best area
-      std::list<Dimensions>::iterator best = sizes.begin();
-      float bestArea = best->height * best->width;
-      for(std::list<Dimensions>::iterator current = sizes.begin(); current != sizes.end(); current++)
+   }
+   else //it is a horizontal slice
+   {
+      COUNTER_ADD(candidatePairs, right->sizes.size() * left->sizes.size());
+      for (uint32_t i = 0; i < right->sizes.size(); i++)
       {
-         float cArea = current->height * current->width;
-         if(cArea < bestArea) //if better area found update
+         for (uint32_t j = 0; j < left->sizes.size(); j++)
          {
-            best = current;
-            bestArea = cArea;
+            Dimensions nSize;
+            nSize.width = std::max(right->sizes.width[i], left->sizes.width[j]);
+            nSize.height = right->sizes.height[i] + left->sizes.height[j];
+            nSize.rSelected = i;
+            nSize.lSelected = j;
+            addToDimensions(nSize);
          }
       }
-      area = bestArea;
-      selected = *best;
-      aspectRatio = selected.height / selected.width;
    }
+
+   COUNTER_MAX(peakSizes, sizes.size());
+   //Calculate best area
+   selected = sizes[minAreaIndex(sizes)];
+   area = selected.height * selected.width;
+   aspectRatio = selected.height / selected.width;
    return area;
 }
 
@@ -199,49 +291,59 @@ void SNode::calcWandH()
    //calculate normal height and width
    size.height = sqrt(aspectRatio * area);
    size.width = area / size.height;
+   size.rSelected = 0;
+   size.lSelected = 0;
+   //a cell has at most two sizes, the second one is its rotation
+   sizes.reserve(2);
    sizes.push_back(size);
-   //add additional possibilities if not fixed
-   if (!fixed)
+   //add additional possibilities if not fixed, a square cell only has one
+   if ((!fixed) && (size.height != size.width))
    {
       float temp = size.height;
       size.height = size.width;
       size.width = temp;
-      sizes.push_back(size);
+      //for a cell the indices name the option and whether it is rotated
+      size.rSelected = 0;
+      size.lSelected = 1;
+      //keep the sizes sorted by width
+      sizes.insert((size.width < sizes.width[0])? 0 : 1, size);
    }
 }
 
 /***********************************************************************************
  * Function:addToDimensions
  * @brief adds new dimension to the list after checking that the new value is not
- *    redundant to the list. 
+ *    redundant to the list. The list stays sorted by width so only the neighbours
+ *    of the new size have to be checked
  * @param nDimension the dimension to be added to the list
  * @return true if value was added false if it was not
 ************************************************************************************/
 bool SNode::addToDimensions(Dimensions &nDimension)
 {
-   //get rid of redundant sizes
-   std::list<Dimensions>::iterator item = sizes.begin();
-   while (item != sizes.end())
+   //first size that is at least as wide as the new one
+   uint32_t item = sizes.lowerBound(nDimension.width);
+   //a narrower size that is no taller is better so return
+   if ((item > 0) && (sizes.height[item - 1] <= nDimension.height))
    {
-      if(nDimension == *item) // same item already exists so return
-      {
-         return false;
-      }
-      else if ((item->height <= nDimension.height) && (item->width <= nDimension.width)) //better item found so return
-      {
-         return false;
-      }
-      else if ((item->height >= nDimension.height) && (item->width >= nDimension.width)) //new item better so remove old
-      {
-         item = sizes.erase(item);
-      }
-      else
-      {
-         item++;
-      }
+      COUNTER_INCREMENT(dimensionsRejected);
+      return false;
    }
-   //add on to the back
-   sizes.push_back(nDimension);
+   //the same or a better item of the same width already exists so return
+   if ((item < sizes.size()) && (sizes.width[item] == nDimension.width) && (sizes.height[item] <= nDimension.height))
+   {
+      COUNTER_INCREMENT(dimensionsRejected);
+      return false;
+   }
+   //get rid of the wider sizes that are no shorter
+   uint32_t last = item;
+   while ((last < sizes.size()) && (sizes.height[last] >= nDimension.height))
+   {
+      last++;
+   }
+   COUNTER_ADD(dimensionsErased, last - item);
+   COUNTER_INCREMENT(dimensionsAccepted);
+   sizes.erase(item, last);
+   sizes.insert(item, nDimension);
    return true;
 }
 
@@ -256,7 +358,7 @@ std::ostream & operator << (std::ostream & out, const SNode & rhs)
 {
    if(rhs.isOperator)
    {
-      out << *(rhs.left) << *(rhs.right) <<  rhs.name;
+      out << *(rhs.left) << ' ' << *(rhs.right) << ' ' <<  rhs.name;
    }
    else
    {
@@ -265,15 +367,4 @@ std::ostream & operator << (std::ostream & out, const SNode & rhs)
    return out;
 }
 
-/***********************************************************************************
- * Operator: Equivalence
- * @brief equivalence operator for the Dimensions struct
- * @param lhs the left hand side of the operator
- * @param rhs the right hand side of the operator
-************************************************************************************/
-bool operator== (const Dimensions &lhs, const Dimensions &rhs)
-{
-   return ((lhs.height == rhs.height) && (lhs.width == rhs.width));
-}
-
 #endif
\ No newline at end of file
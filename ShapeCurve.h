@@ -0,0 +1,358 @@
+/***********************************************************************************
+ * File: ShapeCurve.h
+ * @brief Contains the ShapeCurve class, the list of possible sizes of a cell or a
+ *    group of cells stored as flat arrays
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef SHAPECURVE_H
+#define SHAPECURVE_H
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "NPE.h"
+#include "Counters.h"
+
+/***********************************************************************************
+ * Struct: Dimensions
+ * @brief Contains the dimensions of the cell (height and width) and the index of
+ *    the size of each child that produced it
+************************************************************************************/
+struct Dimensions
+{
+   float height;
+   float width;
+   uint32_t rSelected;
+   uint32_t lSelected;
+};
+
+bool operator== (const Dimensions &lhs, const Dimensions &rhs);
+
+/***********************************************************************************
+ * Class: ShapeCurve
+ * @brief the non-redundant sizes of a cell sorted by increasing width (and so
+ *    decreasing height). Each field is its own array so the merges walk contiguous
+ *    memory, and the sizes of the children are referred to by index
+************************************************************************************/
+class ShapeCurve
+{
+public:
+   std::vector<float> width;
+   std::vector<float> height;
+   std::vector<uint32_t> rSelected; //index of the size used from the right child
+   std::vector<uint32_t> lSelected; //index of the size used from the left child
+   uint32_t size() const;
+   bool empty() const;
+   void clear();
+   void reserve(uint32_t count);
+   void push_back(const Dimensions &nDimension);
+   void insert(uint32_t position, const Dimensions &nDimension);
+   void erase(uint32_t first, uint32_t last);
+   void reverse();
+   uint32_t lowerBound(float nWidth) const;
+   Dimensions operator[](uint32_t i) const;
+};
+
+/***********************************************************************************
+ * Struct: CurvePruning
+ * @brief Contains how far the sizes of an operator may be thinned out, trading 
+ *    accuracy for shorter curves. The default keeps every size
+************************************************************************************/
+struct CurvePruning
+{
+   float epsilon;      //a size within this fraction of the height of a kept one is dropped
+   uint32_t maxPoints; //the most sizes kept for an operator, 0 for no limit
+   CurvePruning();
+};
+
+void mergeCurves(int32_t cut, const ShapeCurve &left, const ShapeCurve &right, ShapeCurve &result);
+uint32_t minAreaIndex(const ShapeCurve &curve);
+float pruneCurve(ShapeCurve &curve, const CurvePruning &pruning);
+
+/***********************************************************************************
+ * Constructor: CurvePruning
+ * @brief constructs the setting that keeps every size
+************************************************************************************/
+CurvePruning::CurvePruning()
+{
+   this->epsilon = 0;
+   this->maxPoints = 0;
+}
+
+/***********************************************************************************
+ * Function: size
+ * @brief gets the number of sizes in the curve
+ * @return the number of sizes
+************************************************************************************/
+uint32_t ShapeCurve::size() const
+{
+   return width.size();
+}
+
+/***********************************************************************************
+ * Function: empty
+ * @brief checks if the curve has no sizes
+ * @return true if there are no sizes
+************************************************************************************/
+bool ShapeCurve::empty() const
+{
+   return width.empty();
+}
+
+/***********************************************************************************
+ * Function: clear
+ * @brief removes every size, keeping the memory for the next use
+************************************************************************************/
+void ShapeCurve::clear()
+{
+   width.clear();
+   height.clear();
+   rSelected.clear();
+   lSelected.clear();
+}
+
+/***********************************************************************************
+ * Function: reserve
+ * @brief makes room for a number of sizes so adding them does not reallocate
+ * @param count the number of sizes the curve will hold
+************************************************************************************/
+void ShapeCurve::reserve(uint32_t count)
+{
+   width.reserve(count);
+   height.reserve(count);
+   rSelected.reserve(count);
+   lSelected.reserve(count);
+}
+
+/***********************************************************************************
+ * Function: push_back
+ * @brief adds a size after the last one
+ * @param nDimension the size to be added
+************************************************************************************/
+void ShapeCurve::push_back(const Dimensions &nDimension)
+{
+   width.push_back(nDimension.width);
+   height.push_back(nDimension.height);
+   rSelected.push_back(nDimension.rSelected);
+   lSelected.push_back(nDimension.lSelected);
+}
+
+/***********************************************************************************
+ * Function: insert
+ * @brief adds a size before the one at the given index
+ * @param position the index the new size will have
+ * @param nDimension the size to be added
+************************************************************************************/
+void ShapeCurve::insert(uint32_t position, const Dimensions &nDimension)
+{
+   width.insert(width.begin() + position, nDimension.width);
+   height.insert(height.begin() + position, nDimension.height);
+   rSelected.insert(rSelected.begin() + position, nDimension.rSelected);
+   lSelected.insert(lSelected.begin() + position, nDimension.lSelected);
+}
+
+/***********************************************************************************
+ * Function: erase
+ * @brief removes the sizes in a range of indices
+ * @param first the index of the first size to remove
+ * @param last the index after the last size to remove
+************************************************************************************/
+void ShapeCurve::erase(uint32_t first, uint32_t last)
+{
+   width.erase(width.begin() + first, width.begin() + last);
+   height.erase(height.begin() + first, height.begin() + last);
+   rSelected.erase(rSelected.begin() + first, rSelected.begin() + last);
+   lSelected.erase(lSelected.begin() + first, lSelected.begin() + last);
+}
+
+/***********************************************************************************
+ * Function: reverse
+ * @brief reverses the order of the sizes
+************************************************************************************/
+void ShapeCurve::reverse()
+{
+   std::reverse(width.begin(), width.end());
+   std::reverse(height.begin(), height.end());
+   std::reverse(rSelected.begin(), rSelected.end());
+   std::reverse(lSelected.begin(), lSelected.end());
+}
+
+/***********************************************************************************
+ * Function: lowerBound
+ * @brief finds the first size that is at least as wide as the given width
+ * @param nWidth the width to search for
+ * @return the index of the size, or size() if every size is narrower
+************************************************************************************/
+uint32_t ShapeCurve::lowerBound(float nWidth) const
+{
+   return std::lower_bound(width.begin(), width.end(), nWidth) - width.begin();
+}
+
+/***********************************************************************************
+ * Operator: subscript
+ * @brief gets the size at an index
+ * @param i the index of the size
+ * @return the size as Dimensions
+************************************************************************************/
+Dimensions ShapeCurve::operator[](uint32_t i) const
+{
+   Dimensions size;
+   size.width = width[i];
+   size.height = height[i];
+   size.rSelected = rSelected[i];
+   size.lSelected = lSelected[i];
+   return size;
+}
+
+/***********************************************************************************
+ * Function: mergeCurves
+ * @brief combines the curves of the children of a slice in a single pass 
+ *    (Stockmeyer). For a vertical slice the taller of the two current sizes limits
+ *    the height of the pair, so only moving past it can produce a better size. A
+ *    horizontal slice works the same with width and height exchanged, walking both
+ *    curves from their widest size and reversing the result to keep the width 
+ *    order. Either way there are at most n+m-1 sizes
+ * @param cut verticalCut or horizontalCut
+ * @param left the curve of the left child
+ * @param right the curve of the right child
+ * @param result the curve the sizes are written to, its memory is reused
+************************************************************************************/
+void mergeCurves(int32_t cut, const ShapeCurve &left, const ShapeCurve &right, ShapeCurve &result)
+{
+   result.clear();
+   Dimensions nSize;
+   if (cut == verticalCut)
+   {
+      uint32_t i = 0;
+      uint32_t j = 0;
+      while ((i < right.size()) && (j < left.size()))
+      {
+         nSize.width = right.width[i] + left.width[j];
+         nSize.height = std::max(right.height[i], left.height[j]);
+         nSize.rSelected = i;
+         nSize.lSelected = j;
+         result.push_back(nSize);
+         bool moveRight = right.height[i] >= left.height[j];
+         bool moveLeft = left.height[j] >= right.height[i];
+         if (moveRight)
+         {
+            i++;
+         }
+         if (moveLeft)
+         {
+            j++;
+         }
+      }
+   }
+   else //it is a horizontal slice
+   {
+      uint32_t i = right.size();
+      uint32_t j = left.size();
+      while ((i > 0) && (j > 0))
+      {
+         nSize.width = std::max(right.width[i - 1], left.width[j - 1]);
+         nSize.height = right.height[i - 1] + left.height[j - 1];
+         nSize.rSelected = i - 1;
+         nSize.lSelected = j - 1;
+         result.push_back(nSize);
+         bool moveRight = right.width[i - 1] >= left.width[j - 1];
+         bool moveLeft = left.width[j - 1] >= right.width[i - 1];
+         if (moveRight)
+         {
+            i--;
+         }
+         if (moveLeft)
+         {
+            j--;
+         }
+      }
+      result.reverse();
+   }
+   COUNTER_ADD(candidatePairs, result.size());
+}
+
+/***********************************************************************************
+ * Function: minAreaIndex
+ * @brief finds the size of smallest area, the first one if there is a tie
+ * @param curve the curve to search, must not be empty
+ * @return the index of the size
+************************************************************************************/
+uint32_t minAreaIndex(const ShapeCurve &curve)
+{
+   uint32_t best = 0;
+   float bestArea = curve.height[0] * curve.width[0];
+   for (uint32_t current = 1; current < curve.size(); current++)
+   {
+      float cArea = curve.height[current] * curve.width[current];
+      if (cArea < bestArea) //if better area found update
+      {
+         best = current;
+         bestArea = cArea;
+      }
+   }
+   return best;
+}
+
+/***********************************************************************************
+ * Operator: Equivalence
+ * @brief equivalence operator for the Dimensions struct
+ * @param lhs the left hand side of the operator
+ * @param rhs the right hand side of the operator
+************************************************************************************/
+bool operator== (const Dimensions &lhs, const Dimensions &rhs)
+{
+   return ((lhs.height == rhs.height) && (lhs.width == rhs.width));
+}
+
+/***********************************************************************************
+ * Function: pruneCurve
+ * @brief thins out a curve. Walking from the narrowest size, a size is only kept
+ *    when it is more than a factor of 1+epsilon shorter than the last kept one, so
+ *    every dropped size has a kept size that is no wider and at most that factor
+ *    taller. When more than maxPoints sizes would remain the factor is raised to
+ *    the range of heights to the power 1/(maxPoints-1), which leaves fewer than
+ *    maxPoints steps. Kept sizes keep their indices into the children
+ * @param curve the curve to thin out, sorted by width
+ * @param pruning how far the curve may be thinned out
+ * @return the largest factor by which a dropped size was covered, 1 if none was
+************************************************************************************/
+float pruneCurve(ShapeCurve &curve, const CurvePruning &pruning)
+{
+   uint32_t count = curve.size();
+   float ratio = 1 + pruning.epsilon;
+   if ((pruning.maxPoints > 0) && (count > pruning.maxPoints))
+   {
+      float range = curve.height[0] / curve.height[count - 1];
+      float step = (pruning.maxPoints > 1)? pow(range, 1.0f / (pruning.maxPoints - 1)) : INFINITY;
+      ratio = std::max(ratio, step);
+   }
+   if ((ratio <= 1) || (count < 2))
+   {
+      return 1;
+   }
+   float worst = 1;
+   float anchor = curve.height[0];
+   uint32_t kept = 1;
+   for (uint32_t i = 1; i < count; i++)
+   {
+      if (curve.height[i] * ratio < anchor)
+      {
+         curve.width[kept] = curve.width[i];
+         curve.height[kept] = curve.height[i];
+         curve.rSelected[kept] = curve.rSelected[i];
+         curve.lSelected[kept] = curve.lSelected[i];
+         anchor = curve.height[i];
+         kept++;
+      }
+      else
+      {
+         worst = std::max(worst, anchor / curve.height[i]);
+      }
+   }
+   curve.erase(kept, count);
+   return worst;
+}
+
+#endif
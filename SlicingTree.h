@@ -0,0 +1,729 @@
+/***********************************************************************************
+ * File: SlicingTree.h
+ * @brief Contains the SlicingTree class, a persistent slicing tree that keeps the
+ *    sizes of every operator between moves and only recalculates the operators
+ *    whose subtree changed
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef SLICINGTREE_H
+#define SLICINGTREE_H
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "NPE.h"
+#include "NPEState.h"
+#include "SNode.h"
+#include "ShapeCurve.h"
+#include "CellLibrary.h"
+#include "Counters.h"
+#include "CurveCache.h"
+
+//defined in Floorplan.h
+bool isValidNPE(const NPE &npe, int cellCount);
+
+/***********************************************************************************
+ * Struct: TreeNode
+ * @brief Contains one element of the Normalized Polish Expression, linked to the
+ *    rest of the tree by position
+************************************************************************************/
+struct TreeNode
+{
+   int32_t token;     //the cell ID, or verticalCut or horizontalCut for an operator
+   int left;          //position of the left child, -1 for a cell
+   int right;         //position of the right child, -1 for a cell
+   int parent;        //position of the parent, -1 for the root
+   const SNode * cell; //the cell of an operand, NULL for an operator
+   ShapeCurve sizes;  //the sizes of an operator
+   float area;        //the smallest area of the sizes
+   uint64_t hash;     //rolling hash of the sub-expression rooted here
+   uint64_t power;    //hashBase to the length of the sub-expression
+   int span;          //the length of the sub-expression, which ends at this position
+   float error;       //factor by which pruning may have enlarged the sizes, 1 if exact
+   bool dirty;        //true while the sizes are waiting to be recalculated
+};
+
+/***********************************************************************************
+ * Struct: Move
+ * @brief Describes a move applied to the expression. Every move is its own
+ *    inverse, so applying it a second time undoes it
+************************************************************************************/
+struct Move
+{
+   int type;   //1, 2 or 3 for the M1, M2 and M3 moves
+   int first;  //M1: first operand, M2: first operator of the chain, M3: first of the pair
+   int second; //M1: second operand, M2: position after the chain, M3: unused
+};
+
+/***********************************************************************************
+ * Struct: Placement
+ * @brief Contains where a cell ends up in the floorplan
+************************************************************************************/
+struct Placement
+{
+   float x;      //left edge
+   float y;      //bottom edge
+   float width;
+   float height;
+   bool rotated; //true if the cell is turned from the size given by its aspect ratio
+};
+
+/***********************************************************************************
+ * Struct: Corner
+ * @brief Contains a subtree waiting to be placed
+************************************************************************************/
+struct Corner
+{
+   int position;   //the position of its root
+   uint32_t index; //the index of the size chosen for it
+   float x;        //its lower left corner
+   float y;
+};
+
+/***********************************************************************************
+ * Struct: PlacedNode
+ * @brief Contains what the placement of a subtree was last worked out from, which
+ *    fixes the placement of every cell in it
+************************************************************************************/
+struct PlacedNode
+{
+   uint64_t hash;  //the hash of the sub-expression
+   uint32_t index; //the index of the size chosen for it
+   float x;        //its corner
+   float y;
+};
+
+/***********************************************************************************
+ * Struct: UndoRecord
+ * @brief Contains what an evaluation overwrote at one operator, its sizes are kept
+ *    in the undo buffer of the same index
+************************************************************************************/
+struct UndoRecord
+{
+   int position;  //the position of the operator
+   float area;    //the area before the evaluation
+   uint64_t hash; //the hash, its power and its span before the evaluation
+   uint64_t power;
+   int span;
+   float error;   //the pruning error before the evaluation
+};
+
+/***********************************************************************************
+ * Class: SlicingTree
+ * @brief slicing tree stored as a flat array in the order of the Normalized Polish
+ *    Expression (postorder), so every child comes before its parent. Building the
+ *    tree is one forward sweep with an explicit stack of the subtrees built so far.
+ *    The operator at a position keeps its sizes until a move changes its subtree,
+ *    at which point it and its ancestors are marked dirty and recalculated by the
+ *    next call to evaluate(). Until commit() is called the moves and the sizes 
+ *    they overwrote are logged, so rollback() can restore the previous tree by 
+ *    swapping buffers back instead of recalculating the sizes. Every node also 
+ *    carries the rolling hash of its sub-expression, so with a cache set the sizes
+ *    of a sub-expression seen before are copied instead of merged. In postorder a
+ *    sub-expression is the run of tokens ending at its root, so its length is all
+ *    the cache needs to check a hit against the expression. With pruning set 
+ *    every curve is thinned out after its merge and every node tracks how much 
+ *    that may have enlarged its sizes: the larger factor of its children times its
+ *    own, since sums and maximums of enlarged sizes are enlarged by the same factor
+************************************************************************************/
+class SlicingTree
+{
+public:
+   SlicingTree();
+   void setCache(CurveCache *cache);
+   void setPruning(const CurvePruning &pruning);
+   void build(const NPE &npe, const CellLibrary &cells, bool trusted = false);
+   float evaluate(float cutoff = INFINITY);
+   void swapOperands(int i, int j);
+   void complementChain(int begin, int end);
+   void swapOperandOperator(int i);
+   void apply(const Move &move);
+   void commit();
+   void rollback();
+   const NPE & getNPE() const;
+   const NPEState & getState() const;
+   uint64_t subtreeHash(int position) const;
+   void place(std::vector<Placement> &placements);
+   void place(std::vector<Placement> &placements, std::vector<int32_t> &moved);
+   float areaError() const;
+private:
+   NPEState state; //the expression the tree currently represents
+   std::vector<TreeNode> nodes; //one node for every position of the expression
+   std::vector<int> stack;      //subtrees waiting for their parent while building
+   int cellCount;               //the number of cells in the library of the tree
+   std::vector<PlacedNode> placed; //every position as of the last placement
+   std::vector<Corner> pending;    //subtrees waiting to be placed
+   std::vector<int> dirty;      //operators waiting to be recalculated
+   std::vector<Move> undoMoves; //moves since the last commit
+   std::vector<UndoRecord> undoRecords; //operators recalculated since the last commit
+   std::vector<ShapeCurve> undoBuffers; //their previous sizes, reused from commit to commit
+   CurveCache * cache; //sizes of sub-expressions seen before, NULL for none
+   CurvePruning pruning;
+   void combine(int position);
+   const ShapeCurve & curve(int position) const;
+   void markDirty(int position);
+   void setChild(int position, int oldChild, int newChild);
+   void setChildren(int position, int leftChild, int rightChild);
+};
+
+/***********************************************************************************
+ * Constructor: SlicingTree
+ * @brief constructs an empty tree without a cache
+************************************************************************************/
+SlicingTree::SlicingTree()
+{
+   this->cache = NULL;
+}
+
+/***********************************************************************************
+ * Function: setCache
+ * @brief sets the cache consulted before merging the sizes of an operator
+ * @param cache the cache, which must outlive the tree, or NULL for none
+************************************************************************************/
+void SlicingTree::setCache(CurveCache *cache)
+{
+   this->cache = cache;
+}
+
+/***********************************************************************************
+ * Function: setPruning
+ * @brief sets how far the sizes of the operators are thinned out, taking effect 
+ *    from the next build
+ * @param pruning how far the curves may be thinned out
+************************************************************************************/
+void SlicingTree::setPruning(const CurvePruning &pruning)
+{
+   this->pruning = pruning;
+}
+
+/***********************************************************************************
+ * Function: build
+ * @brief builds and evaluates the tree for a Normalized Polish Expression from
+ *    scratch, reusing the memory of the previous tree
+ * @param npe the Normalized Polish Expression
+ * @param cells the cells to be arranged
+ * @param trusted skips validating an expression known to be valid, such as one 
+ *    produced by the moves of the annealer
+************************************************************************************/
+void SlicingTree::build(const NPE &npe, const CellLibrary &cells, bool trusted)
+{
+   COUNTER_INCREMENT(treeBuilds);
+   //Validate npe
+   if(!trusted && !isValidNPE(npe, cells.size()))
+   {
+      throw "Invalid NPE!";
+   }
+   state.assign(npe);
+   undoMoves.clear();
+   undoRecords.clear();
+   int size = npe.size();
+   nodes.resize(size);
+   dirty.clear();
+   stack.clear();
+   cellCount = cells.size();
+   for (int p = 0; p < size; p++)
+   {
+      TreeNode &node = nodes[p];
+      node.token = npe[p];
+      node.left = -1;
+      node.right = -1;
+      node.parent = -1;
+      node.cell = NULL;
+      node.dirty = false;
+      if (isOperator(npe[p]))
+      {
+         //both children are complete so the operator can be evaluated right away
+         int rightChild = stack.back();
+         stack.pop_back();
+         int leftChild = stack.back();
+         stack.pop_back();
+         setChildren(p, leftChild, rightChild);
+         combine(p);
+      }
+      else
+      {
+         //find the opperand in the cells
+         node.cell = cells.find(npe[p]);
+         if (!node.cell) //item not found in cells
+         {
+            throw "Cell data not valid!";
+         }
+         node.area = node.cell->area;
+         node.hash = tokenHash(node.token);
+         node.power = hashBase;
+         node.span = 1;
+         node.error = 1;
+      }
+      stack.push_back(p);
+   }
+}
+
+/***********************************************************************************
+ * Function: evaluate
+ * @brief recalculates the dirty operators, children before their parents. The 
+ *    previous sizes of every operator are swapped into the undo buffers rather 
+ *    than overwritten. Every size of the root contains a size of each subtree, so
+ *    the area of the floorplan is at least the smallest area of any subtree and at
+ *    least the widest smallest width times the tallest smallest height of them. 
+ *    Once either bound passes the cutoff the rest is left dirty; rollback() or
+ *    another evaluate() deals with it
+ * @param cutoff the area above which the exact result is not needed
+ * @return the area of the overall floorplan, or INFINITY if it is above the cutoff
+************************************************************************************/
+float SlicingTree::evaluate(float cutoff)
+{
+   //in postfix order every child comes before its parent
+   std::sort(dirty.begin(), dirty.end());
+   float minWidth = 0;
+   float minHeight = 0;
+   for (int i = 0; i < (int)dirty.size(); i++)
+   {
+      TreeNode &node = nodes[dirty[i]];
+      if (undoRecords.size() == undoBuffers.size())
+      {
+         undoBuffers.push_back(ShapeCurve());
+      }
+      UndoRecord record;
+      record.position = dirty[i];
+      record.area = node.area;
+      record.hash = node.hash;
+      record.power = node.power;
+      record.span = node.span;
+      record.error = node.error;
+      std::swap(node.sizes, undoBuffers[undoRecords.size()]);
+      undoRecords.push_back(record);
+      combine(dirty[i]);
+      node.dirty = false;
+      minWidth = std::max(minWidth, node.sizes.width.front());
+      minHeight = std::max(minHeight, node.sizes.height.back());
+      if ((node.area > cutoff) || (minWidth * minHeight > cutoff))
+      {
+         COUNTER_INCREMENT(evaluationsCut);
+         dirty.erase(dirty.begin(), dirty.begin() + i + 1);
+         return INFINITY;
+      }
+   }
+   dirty.clear();
+   return nodes.back().area;
+}
+
+/***********************************************************************************
+ * Function: swapOperands
+ * @brief swaps two operands (the M1 move), the shape of the tree does not change
+ * @param i the position of the first operand
+ * @param j the position of the second operand
+************************************************************************************/
+void SlicingTree::swapOperands(int i, int j)
+{
+   Move move = {1, i, j};
+   undoMoves.push_back(move);
+   state.swapOperands(i, j);
+   std::swap(nodes[i].token, nodes[j].token);
+   std::swap(nodes[i].cell, nodes[j].cell);
+   std::swap(nodes[i].area, nodes[j].area);
+   std::swap(nodes[i].hash, nodes[j].hash);
+   markDirty(nodes[i].parent);
+   markDirty(nodes[j].parent);
+}
+
+/***********************************************************************************
+ * Function: complementChain
+ * @brief complements the operators in a range (the M2 move)
+ * @param begin the position of the first operator
+ * @param end the position after the last operator
+************************************************************************************/
+void SlicingTree::complementChain(int begin, int end)
+{
+   Move move = {2, begin, end};
+   undoMoves.push_back(move);
+   for (int p = begin; p < end; p++)
+   {
+      state.complement(p);
+      nodes[p].token = complement(nodes[p].token);
+      markDirty(p);
+   }
+}
+
+/***********************************************************************************
+ * Function: swapOperandOperator
+ * @brief swaps the adjacent operand and operator at i and i+1 (the M3 move). The
+ *    resulting expression must still be valid. Only the nodes around the swap are
+ *    relinked, every other subtree keeps its position and its sizes
+ * @param i the position of the first element of the pair
+************************************************************************************/
+void SlicingTree::swapOperandOperator(int i)
+{
+   Move move = {3, i, i + 1};
+   undoMoves.push_back(move);
+   //the sizes buffer follows the operator so its memory is reused
+   state.swapOperandOperator(i);
+   std::swap(nodes[i].token, nodes[i + 1].token);
+   std::swap(nodes[i].cell, nodes[i + 1].cell);
+   std::swap(nodes[i].area, nodes[i + 1].area);
+   std::swap(nodes[i].sizes, nodes[i + 1].sizes);
+   std::swap(nodes[i].hash, nodes[i + 1].hash);
+   std::swap(nodes[i].power, nodes[i + 1].power);
+   std::swap(nodes[i].span, nodes[i + 1].span);
+   std::swap(nodes[i].error, nodes[i + 1].error);
+   //only the operator can be waiting to be recalculated, its flag follows it
+   if (nodes[i].dirty || nodes[i + 1].dirty)
+   {
+      int from = nodes[i].dirty? i : i + 1;
+      *std::find(dirty.begin(), dirty.end(), from) = 2 * i + 1 - from;
+      std::swap(nodes[i].dirty, nodes[i + 1].dirty);
+   }
+   if (isOperator(nodes[i].token))
+   {
+      //operand a then operator op(T, a) becomes op(S, T) then a, where S is the
+      //subtree below T on the stack: the left child of the first ancestor of the
+      //operator that is reached from a right child
+      int op = i + 1;
+      int t = nodes[op].left;
+      int opParent = nodes[op].parent;
+      int subtree = op;
+      while (nodes[nodes[subtree].parent].left == subtree)
+      {
+         subtree = nodes[subtree].parent;
+      }
+      int stackBelow = nodes[subtree].parent;
+      int s = nodes[stackBelow].left;
+      nodes[op].left = -1;
+      nodes[op].right = -1;
+      //the operator takes the place of S and the operand the place of the operator
+      setChildren(i, s, t);
+      setChild(stackBelow, s, i);
+      setChild(opParent, op, op);
+      markDirty(i);
+      markDirty(opParent);
+   }
+   else
+   {
+      //operator op(S, T) then operand a becomes operand a then op(T, a)
+      int op = i;
+      int a = i + 1;
+      int s = nodes[op].left;
+      int t = nodes[op].right;
+      int opParent = nodes[op].parent;
+      int aParent = nodes[a].parent;
+      nodes[op].left = -1;
+      nodes[op].right = -1;
+      //S takes the place of the operator and the operator the place of the operand
+      setChild(opParent, op, s);
+      setChild(aParent, a, a);
+      setChildren(a, t, op);
+      markDirty(a);
+      markDirty(opParent);
+   }
+}
+
+/***********************************************************************************
+ * Function: apply
+ * @brief applies a move to the tree, applying it again undoes it. Any number of 
+ *    moves may be applied before the next evaluate() or rollback()
+ * @param move the move to be applied
+************************************************************************************/
+void SlicingTree::apply(const Move &move)
+{
+   if (move.type == 1)
+   {
+      swapOperands(move.first, move.second);
+   }
+   else if (move.type == 2)
+   {
+      complementChain(move.first, move.second);
+   }
+   else
+   {
+      swapOperandOperator(move.first);
+   }
+}
+
+/***********************************************************************************
+ * Function: commit
+ * @brief keeps the moves since the last commit, the undo buffers are kept for 
+ *    reuse
+************************************************************************************/
+void SlicingTree::commit()
+{
+   undoMoves.clear();
+   undoRecords.clear();
+}
+
+/***********************************************************************************
+ * Function: rollback
+ * @brief returns the tree to how it was at the last commit. The overwritten sizes
+ *    are swapped back newest first, which leaves every operator as it was right
+ *    after the moves, then the moves are undone newest first. Every size is then
+ *    already correct for the restored tree, so nothing is recalculated
+************************************************************************************/
+void SlicingTree::rollback()
+{
+   for (int k = (int)undoRecords.size() - 1; k >= 0; k--)
+   {
+      TreeNode &node = nodes[undoRecords[k].position];
+      std::swap(node.sizes, undoBuffers[k]);
+      node.area = undoRecords[k].area;
+      node.hash = undoRecords[k].hash;
+      node.power = undoRecords[k].power;
+      node.span = undoRecords[k].span;
+      node.error = undoRecords[k].error;
+   }
+   //undoing the moves logs them again, so only the original ones are replayed
+   for (int k = (int)undoMoves.size() - 1; k >= 0; k--)
+   {
+      Move move = undoMoves[k];
+      apply(move);
+   }
+   for (int i = 0; i < (int)dirty.size(); i++)
+   {
+      nodes[dirty[i]].dirty = false;
+   }
+   dirty.clear();
+   commit();
+}
+
+/***********************************************************************************
+ * Function: getNPE
+ * @brief gets the Normalized Polish Expression the tree currently represents
+ * @return the Normalized Polish Expression as tokens
+************************************************************************************/
+const NPE & SlicingTree::getNPE() const
+{
+   return state.getNPE();
+}
+
+/***********************************************************************************
+ * Function: getState
+ * @brief gets the expression along with its operator counts, for checking moves
+ * @return the state of the Normalized Polish Expression
+************************************************************************************/
+const NPEState & SlicingTree::getState() const
+{
+   return state;
+}
+
+/***********************************************************************************
+ * Function: subtreeHash
+ * @brief gets the rolling hash of the sub-expression rooted at a position, equal 
+ *    for equal sub-expressions wherever they appear in the expression. The hashes
+ *    of operators are only current after evaluate()
+ * @param position the position of the root of the subtree
+ * @return the hash of the sub-expression
+************************************************************************************/
+uint64_t SlicingTree::subtreeHash(int position) const
+{
+   return nodes[position].hash;
+}
+
+/***********************************************************************************
+ * Function: place
+ * @brief gives every cell its coordinates for the smallest size of the floorplan.
+ *    Working down from the root, the size chosen at an operator names by index the
+ *    size of each child that produced it, so every node is visited once with an 
+ *    explicit stack. A vertical cut puts the left child on the left and a 
+ *    horizontal cut puts it on the bottom. For a cell the indices of the chosen 
+ *    size tell whether it is rotated
+ * @param placements the placement of every cell indexed by ID, cells that are not
+ *    in the tree are left as they are
+************************************************************************************/
+void SlicingTree::place(std::vector<Placement> &placements)
+{
+   std::vector<int32_t> moved;
+   placed.clear();
+   place(placements, moved);
+}
+
+/***********************************************************************************
+ * Function: place
+ * @brief updates the coordinates of the cells from the last placement. The same
+ *    sub-expression with the same chosen size at the same corner places its cells
+ *    exactly as before, so such subtrees are skipped and only the cells of the
+ *    others are written
+ * @param placements the placement of every cell indexed by ID, as left by the 
+ *    last call
+ * @param moved filled with the IDs of the cells whose placement was written
+************************************************************************************/
+void SlicingTree::place(std::vector<Placement> &placements, std::vector<int32_t> &moved)
+{
+   moved.clear();
+   if (!dirty.empty())
+   {
+      evaluate();
+   }
+   if ((int)placements.size() < cellCount)
+   {
+      placements.resize(cellCount);
+   }
+   if (placed.size() != nodes.size())
+   {
+      //nothing is known about a tree of another size
+      PlacedNode unknown = {0, UINT32_MAX, 0, 0};
+      placed.assign(nodes.size(), unknown);
+   }
+   pending.clear();
+   Corner root = {(int)nodes.size() - 1, 0, 0, 0};
+   root.index = minAreaIndex(curve(root.position));
+   pending.push_back(root);
+   while (!pending.empty())
+   {
+      Corner corner = pending.back();
+      pending.pop_back();
+      const TreeNode &node = nodes[corner.position];
+      const ShapeCurve &sizes = curve(corner.position);
+      PlacedNode &last = placed[corner.position];
+      if ((last.hash == node.hash) && (last.index == corner.index) && (last.x == corner.x) && (last.y == corner.y))
+      {
+         continue;
+      }
+      last.hash = node.hash;
+      last.index = corner.index;
+      last.x = corner.x;
+      last.y = corner.y;
+      if (node.cell)
+      {
+         moved.push_back(node.token);
+         Placement &placement = placements[node.token];
+         placement.x = corner.x;
+         placement.y = corner.y;
+         placement.width = sizes.width[corner.index];
+         placement.height = sizes.height[corner.index];
+         placement.rotated = (sizes.lSelected[corner.index] != 0);
+         continue;
+      }
+      Corner left = {node.left, sizes.lSelected[corner.index], corner.x, corner.y};
+      Corner right = {node.right, sizes.rSelected[corner.index], corner.x, corner.y};
+      if (node.token == verticalCut)
+      {
+         right.x += curve(node.left).width[left.index];
+      }
+      else
+      {
+         right.y += curve(node.left).height[left.index];
+      }
+      pending.push_back(right);
+      pending.push_back(left);
+   }
+}
+
+/***********************************************************************************
+ * Function: areaError
+ * @brief gets how much larger than the exact one the area of the floorplan may be 
+ *    because of pruning. Only heights are ever enlarged, so the area is within the
+ *    root's factor of the exact area
+ * @return the worst case relative error of the area, 0 if no size was dropped
+************************************************************************************/
+float SlicingTree::areaError() const
+{
+   return nodes.back().error - 1;
+}
+
+/***********************************************************************************
+ * Function: combine
+ * @brief recalculates the sizes of an operator from the sizes of its children
+ * @param position the position of the operator
+************************************************************************************/
+void SlicingTree::combine(int position)
+{
+   TreeNode &node = nodes[position];
+   const TreeNode &left = nodes[node.left];
+   const TreeNode &right = nodes[node.right];
+   COUNTER_INCREMENT(nodeVisits);
+   //the hash of the sub-expression left right op, the same wherever it appears
+   node.hash = (left.hash * right.power + right.hash) * hashBase + tokenHash(node.token);
+   node.power = left.power * right.power * hashBase;
+   node.span = left.span + right.span + 1;
+   //short merges are cheaper than looking them up
+   bool cached = (cache != NULL) && (curve(node.left).size() + curve(node.right).size() >= cache->minPoints);
+   const int32_t * tokens = &state.getNPE()[position - node.span + 1];
+   const CacheEntry * entry = cached? cache->find(node.hash, tokens, node.span) : NULL;
+   if (entry)
+   {
+      node.sizes = entry->curve;
+      node.error = entry->error;
+   }
+   else
+   {
+      mergeCurves(node.token, curve(node.left), curve(node.right), node.sizes);
+      node.error = std::max(left.error, right.error) * pruneCurve(node.sizes, pruning);
+      if (cached)
+      {
+         cache->insert(node.hash, tokens, node.span, node.sizes, node.error);
+      }
+   }
+   COUNTER_MAX(peakSizes, node.sizes.size());
+   uint32_t best = minAreaIndex(node.sizes);
+   node.area = node.sizes.width[best] * node.sizes.height[best];
+}
+
+/***********************************************************************************
+ * Function: curve
+ * @brief gets the sizes of the node at a position, the cell's own for an operand
+ * @param position the position of the node
+ * @return the sizes of the node
+************************************************************************************/
+const ShapeCurve & SlicingTree::curve(int position) const
+{
+   if (nodes[position].cell)
+   {
+      return nodes[position].cell->sizes;
+   }
+   return nodes[position].sizes;
+}
+
+/***********************************************************************************
+ * Function: markDirty
+ * @brief marks an operator and all of its ancestors as needing recalculation. The
+ *    whole path to the root is walked: after an M3 move a dirty node may have new
+ *    ancestors that are not dirty yet, so when several moves are applied before
+ *    the next evaluate() the first dirty node does not vouch for those above it
+ * @param position the position of the operator
+************************************************************************************/
+void SlicingTree::markDirty(int position)
+{
+   while (position != -1)
+   {
+      if (!nodes[position].dirty)
+      {
+         nodes[position].dirty = true;
+         dirty.push_back(position);
+      }
+      position = nodes[position].parent;
+   }
+}
+
+/***********************************************************************************
+ * Function: setChild
+ * @brief replaces one child of an operator by the node at another position
+ * @param position the position of the operator
+ * @param oldChild the position of the child being replaced
+ * @param newChild the position of the node taking its place
+************************************************************************************/
+void SlicingTree::setChild(int position, int oldChild, int newChild)
+{
+   if (nodes[position].right == oldChild)
+   {
+      setChildren(position, nodes[position].left, newChild);
+   }
+   else
+   {
+      setChildren(position, newChild, nodes[position].right);
+   }
+}
+
+/***********************************************************************************
+ * Function: setChildren
+ * @brief links an operator to its children
+ * @param position the position of the operator
+ * @param leftChild the position of the left child
+ * @param rightChild the position of the right child
+************************************************************************************/
+void SlicingTree::setChildren(int position, int leftChild, int rightChild)
+{
+   nodes[position].left = leftChild;
+   nodes[position].right = rightChild;
+   nodes[leftChild].parent = position;
+   nodes[rightChild].parent = position;
+}
+
+#endif
@@ -0,0 +1,237 @@
+/***********************************************************************************
+ * File: Wirelength.h
+ * @brief Contains the Netlist class which stores the nets connecting the cells and
+ *    the Wirelength class which keeps their half-perimeter wirelength up to date
+ * Author: Brandon Baird
+************************************************************************************/
+
+#ifndef WIRELENGTH_H
+#define WIRELENGTH_H
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include "SlicingTree.h"
+
+/***********************************************************************************
+ * Class: Netlist
+ * @brief the nets of a floorplan in compressed rows: the pins of net n are the
+ *    cell IDs pins[netStart[n]] to pins[netStart[n+1]-1], and the nets of cell c
+ *    are cellNets[cellStart[c]] to cellNets[cellStart[c+1]-1]. Both directions
+ *    are single flat arrays so walking a net or the nets of a cell reads
+ *    contiguous memory
+************************************************************************************/
+class Netlist
+{
+public:
+   std::vector<int32_t> netStart;
+   std::vector<int32_t> pins;
+   std::vector<int32_t> cellStart;
+   std::vector<int32_t> cellNets;
+   Netlist();
+   void addNet(const std::vector<int32_t> &cells);
+   void finish(int cellCount);
+   int size() const;
+};
+
+/***********************************************************************************
+ * Class: Wirelength
+ * @brief the half-perimeter wirelength of a netlist over the centres of the cells.
+ *    After a move only the nets of the cells whose placement changed are measured
+ *    again, each once however many of its cells moved, and the total is adjusted
+ *    by the difference
+************************************************************************************/
+class Wirelength
+{
+public:
+   Wirelength();
+   void setNetlist(const Netlist *nets);
+   float total(const std::vector<Placement> &placements);
+   float update(const std::vector<Placement> &placements, const std::vector<int32_t> &moved);
+private:
+   const Netlist * nets;
+   std::vector<float> centerX;     //the centre of every cell
+   std::vector<float> centerY;
+   std::vector<float> netLength;   //the wirelength of every net
+   std::vector<uint32_t> netStamp; //the update that last measured every net
+   uint32_t stamp;
+   double sum; //kept in double so the differences do not drift
+   float measure(int net) const;
+};
+
+/***********************************************************************************
+ * Constructor: Netlist
+ * @brief constructs a netlist without nets
+************************************************************************************/
+Netlist::Netlist()
+{
+   netStart.push_back(0);
+}
+
+/***********************************************************************************
+ * Function: addNet
+ * @brief adds a net connecting the given cells
+ * @param cells the IDs of the cells on the net
+************************************************************************************/
+void Netlist::addNet(const std::vector<int32_t> &cells)
+{
+   pins.insert(pins.end(), cells.begin(), cells.end());
+   netStart.push_back(pins.size());
+}
+
+/***********************************************************************************
+ * Function: finish
+ * @brief builds the nets of every cell once all nets have been added
+ * @param cellCount the number of cells in the library
+************************************************************************************/
+void Netlist::finish(int cellCount)
+{
+   //count the nets of every cell then fill them in
+   cellStart.assign(cellCount + 1, 0);
+   for (int i = 0; i < (int)pins.size(); i++)
+   {
+      cellStart[pins[i] + 1]++;
+   }
+   for (int c = 0; c < cellCount; c++)
+   {
+      cellStart[c + 1] += cellStart[c];
+   }
+   cellNets.resize(pins.size());
+   std::vector<int32_t> next(cellStart.begin(), cellStart.end() - 1);
+   for (int n = 0; n < size(); n++)
+   {
+      for (int i = netStart[n]; i < netStart[n + 1]; i++)
+      {
+         cellNets[next[pins[i]]++] = n;
+      }
+   }
+}
+
+/***********************************************************************************
+ * Function: size
+ * @brief gets the number of nets
+ * @return the number of nets
+************************************************************************************/
+int Netlist::size() const
+{
+   return netStart.size() - 1;
+}
+
+/***********************************************************************************
+ * Constructor: Wirelength
+ * @brief constructs a wirelength without a netlist
+************************************************************************************/
+Wirelength::Wirelength()
+{
+   this->nets = NULL;
+   this->stamp = 0;
+   this->sum = 0;
+}
+
+/***********************************************************************************
+ * Function: setNetlist
+ * @brief sets the nets to measure
+ * @param nets the netlist, which must outlive the wirelength
+************************************************************************************/
+void Wirelength::setNetlist(const Netlist *nets)
+{
+   this->nets = nets;
+   netLength.assign(nets->size(), 0);
+   netStamp.assign(nets->size(), 0);
+   stamp = 0;
+   sum = 0;
+}
+
+/***********************************************************************************
+ * Function: total
+ * @brief measures every net from scratch
+ * @param placements the placement of every cell indexed by ID
+ * @return the total wirelength
+************************************************************************************/
+float Wirelength::total(const std::vector<Placement> &placements)
+{
+   centerX.resize(placements.size());
+   centerY.resize(placements.size());
+   for (int c = 0; c < (int)placements.size(); c++)
+   {
+      centerX[c] = placements[c].x + placements[c].width / 2;
+      centerY[c] = placements[c].y + placements[c].height / 2;
+   }
+   sum = 0;
+   for (int n = 0; n < nets->size(); n++)
+   {
+      netLength[n] = measure(n);
+      sum += netLength[n];
+   }
+   return sum;
+}
+
+/***********************************************************************************
+ * Function: update
+ * @brief measures again only the nets of the cells that moved
+ * @param placements the placement of every cell indexed by ID
+ * @param moved the IDs of the cells whose placement changed since the last call
+ * @return the total wirelength
+************************************************************************************/
+float Wirelength::update(const std::vector<Placement> &placements, const std::vector<int32_t> &moved)
+{
+   if (centerX.size() != placements.size())
+   {
+      return total(placements);
+   }
+   for (int i = 0; i < (int)moved.size(); i++)
+   {
+      int32_t c = moved[i];
+      centerX[c] = placements[c].x + placements[c].width / 2;
+      centerY[c] = placements[c].y + placements[c].height / 2;
+   }
+   //a net shared by several moved cells is only measured once
+   stamp++;
+   for (int i = 0; i < (int)moved.size(); i++)
+   {
+      int32_t c = moved[i];
+      for (int k = nets->cellStart[c]; k < nets->cellStart[c + 1]; k++)
+      {
+         int n = nets->cellNets[k];
+         if (netStamp[n] != stamp)
+         {
+            netStamp[n] = stamp;
+            float length = measure(n);
+            sum += length - netLength[n];
+            netLength[n] = length;
+         }
+      }
+   }
+   return sum;
+}
+
+/***********************************************************************************
+ * Function: measure
+ * @brief measures the half perimeter of the box around the pins of a net
+ * @param net the net to measure
+ * @return the wirelength of the net
+************************************************************************************/
+float Wirelength::measure(int net) const
+{
+   int first = nets->netStart[net];
+   int last = nets->netStart[net + 1];
+   if (last - first < 2)
+   {
+      return 0;
+   }
+   float minX = centerX[nets->pins[first]];
+   float maxX = minX;
+   float minY = centerY[nets->pins[first]];
+   float maxY = minY;
+   for (int i = first + 1; i < last; i++)
+   {
+      int32_t c = nets->pins[i];
+      minX = std::min(minX, centerX[c]);
+      maxX = std::max(maxX, centerX[c]);
+      minY = std::min(minY, centerY[c]);
+      maxY = std::max(maxY, centerY[c]);
+   }
+   return (maxX - minX) + (maxY - minY);
+}
+
+#endif
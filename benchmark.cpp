@@ -0,0 +1,203 @@
+/***********************************************************************************
+ * Program: Floorplanning benchmarks
+ * @brief Measures the evaluation of Normalized Polish Expressions on synthetic
+ *    designs with Google Benchmark. Run with --benchmark_format=json for results
+ *    that can be compared from build to build
+ * Author: Brandon Baird
+************************************************************************************/
+
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include "SNode.h"
+#include "Floorplan.h"
+
+//the shapes of slicing tree the expressions are built as
+enum TreeShape
+{
+   VERTICAL,   // every cell in one chain of V cuts
+   HORIZONTAL, // every cell in one chain of H cuts
+   BALANCED    // halves cut alternately by V and H
+};
+
+//the orders the sizes are handed to addToDimensions in
+enum InsertionOrder
+{
+   ASCENDING,  // narrowest first, every size is appended
+   DESCENDING, // widest first, every size is inserted at the front
+   RANDOM,     // shuffled
+   DOMINATING  // every size is better than all before it and replaces them
+};
+
+/***********************************************************************************
+ * Function: syntheticCells
+ * @brief fills the library with cells of random area and aspect ratio, the same
+ *    cells for the same count
+ * @param cells the library to fill
+ * @param count the number of cells
+************************************************************************************/
+void syntheticCells(CellLibrary &cells, int count)
+{
+   std::mt19937 random(count);
+   std::uniform_real_distribution<float> area(1, 100);
+   std::uniform_real_distribution<float> aspectRatio(0.25f, 4);
+   for (int i = 0; i < count; i++)
+   {
+      cells.add(SNode("c" + std::to_string(i), area(random), aspectRatio(random)));
+   }
+}
+
+/***********************************************************************************
+ * Function: balancedNPE
+ * @brief appends a balanced tree of the cells first to last - 1, alternating the
+ *    cut at every level so the expression stays normalized
+ * @param npe the expression to append to
+ * @param first the first cell
+ * @param last one past the last cell
+ * @param cut the cut at the root of this subtree
+************************************************************************************/
+void balancedNPE(NPE &npe, int first, int last, int32_t cut)
+{
+   if (last - first == 1)
+   {
+      npe.push_back(first);
+      return;
+   }
+   int middle = (first + last) / 2;
+   balancedNPE(npe, first, middle, complement(cut));
+   balancedNPE(npe, middle, last, complement(cut));
+   npe.push_back(cut);
+}
+
+/***********************************************************************************
+ * Function: syntheticNPE
+ * @brief builds an expression of the requested shape over every cell
+ * @param cells the cells to be arranged
+ * @param shape the shape of the slicing tree
+ * @return the Normalized Polish Expression as tokens
+************************************************************************************/
+NPE syntheticNPE(const CellLibrary &cells, TreeShape shape)
+{
+   NPE npe;
+   if (shape == BALANCED)
+   {
+      balancedNPE(npe, 0, cells.size(), verticalCut);
+      return npe;
+   }
+   int32_t cut = (shape == VERTICAL)? verticalCut : horizontalCut;
+   for (int i = 0; i < cells.size(); i++)
+   {
+      npe.push_back(i);
+      if (i > 0)
+      {
+         npe.push_back(cut);
+      }
+   }
+   return npe;
+}
+
+/***********************************************************************************
+ * Function: reportEvaluations
+ * @brief reports the evaluations per second along with the size of the design
+ * @param state the state of the running benchmark
+ * @param cells the number of cells evaluated each iteration
+************************************************************************************/
+void reportEvaluations(benchmark::State &state, int cells)
+{
+   state.counters["evaluations"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+   state.counters["cells"] = cells;
+}
+
+/***********************************************************************************
+ * Function: costBenchmark
+ * @brief measures cost() of a whole expression, tree building included
+ * @param state the state of the running benchmark, range(0) is the cell count
+ * @param shape the shape of the slicing tree
+************************************************************************************/
+void costBenchmark(benchmark::State &state, TreeShape shape)
+{
+   CellLibrary cells;
+   syntheticCells(cells, state.range(0));
+   NPE npe = syntheticNPE(cells, shape);
+   for (auto _ : state)
+   {
+      benchmark::DoNotOptimize(cost(npe, cells));
+   }
+   reportEvaluations(state, cells.size());
+}
+
+/***********************************************************************************
+ * Function: calcMinAreaBenchmark
+ * @brief measures calcMinArea() on a vertical chain whose shape curves grow by one
+ *    size for every cell, so the root curve is as long as the design
+ * @param state the state of the running benchmark, range(0) is the cell count and
+ *    range(1) the merge mode
+************************************************************************************/
+void calcMinAreaBenchmark(benchmark::State &state)
+{
+   CellLibrary cells;
+   syntheticCells(cells, state.range(0));
+   NPE npe = syntheticNPE(cells, VERTICAL);
+   NodeArena operators;
+   SNode * root = generateTree(npe, cells, operators);
+   SNode::MergeMode mode = SNode::mergeMode;
+   SNode::mergeMode = (SNode::MergeMode)state.range(1);
+   for (auto _ : state)
+   {
+      benchmark::DoNotOptimize(root->calcMinArea());
+   }
+   SNode::mergeMode = mode;
+   state.counters["curve"] = root->sizes.size();
+   reportEvaluations(state, cells.size());
+}
+
+/***********************************************************************************
+ * Function: addToDimensionsBenchmark
+ * @brief measures addToDimensions() filling a shape curve in the requested order
+ * @param state the state of the running benchmark, range(0) is the number of sizes
+ *    and range(1) the insertion order
+************************************************************************************/
+void addToDimensionsBenchmark(benchmark::State &state)
+{
+   int count = state.range(0);
+   InsertionOrder order = (InsertionOrder)state.range(1);
+   //sizes on a staircase so none of them is redundant, unless they dominate
+   std::vector<Dimensions> input(count);
+   for (int i = 0; i < count; i++)
+   {
+      input[i].width = i + 1;
+      input[i].height = (order == DOMINATING)? i + 1 : count - i;
+      input[i].rSelected = 0;
+      input[i].lSelected = 0;
+   }
+   if ((order == DESCENDING) || (order == DOMINATING))
+   {
+      std::reverse(input.begin(), input.end());
+   }
+   else if (order == RANDOM)
+   {
+      std::shuffle(input.begin(), input.end(), std::mt19937(count));
+   }
+   SNode node(verticalCut);
+   for (auto _ : state)
+   {
+      node.sizes.clear();
+      for (int i = 0; i < count; i++)
+      {
+         node.addToDimensions(input[i]);
+      }
+      benchmark::DoNotOptimize(node.sizes.size());
+   }
+   state.SetItemsProcessed(state.iterations() * count);
+}
+
+//skewed chains keep every size of every subtree, so they stop at a few thousand cells
+BENCHMARK_CAPTURE(costBenchmark, vertical, VERTICAL)->RangeMultiplier(10)->Range(10, 1000)->Arg(5000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(costBenchmark, horizontal, HORIZONTAL)->RangeMultiplier(10)->Range(10, 1000)->Arg(5000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(costBenchmark, balanced, BALANCED)->RangeMultiplier(10)->Range(10, 100000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(calcMinAreaBenchmark)->ArgsProduct({{100, 1000, 5000}, {SNode::STOCKMEYER, SNode::REFERENCE}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(addToDimensionsBenchmark)->ArgsProduct({{64, 1024, 16384}, {ASCENDING, DESCENDING, RANDOM, DOMINATING}})->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -6,222 +6,223 @@
 ************************************************************************************/
 
 #include <iostream> 
-#include <fstream> 
 #include <string>
-#include <sstream>
-#include <list>
+#include <fstream>
 #include "SNode.h"
+#include "Floorplan.h"
+#include "Annealer.h"
+#include "ParallelTempering.h"
+#include "BatchScorer.h"
 
-//Initial NPEs for annealing
+//Sample NPEs scored before annealing when the cells they name are loaded
 const std::string initialVerticalNPE = "12V3V4V5V6V7V8V9VaVbVcVdVeVfVgViVjVkVlV";
 const std::string initialHorizontalNPE = "12H3H4H5H6H7H8H9HaHbHcHdHeHfHgHiHjHkHlH";
 const std::string initialOtherNPE = "213546H7VHVa8V9HcVHgHibdHkVHfeHVlHVjHVH";
 
-//functions
-bool isValidNPE(std::string npe);
-void getCells(std::string filename, std::list<SNode> &cells);
-float cost(std::string npe ,std::list<SNode> &cells);
-SNode * generateTree(std::string npe, std::list<SNode> &cells, std::list<SNode> &operators);
-
 /***********************************************************************************
  * Function: main
  * @brief the main routine of the program
 ************************************************************************************/
 int main (int argc , const char* argv[])
 {
-   //Cells of the floorplan
-   std::list<SNode> cells;
-   if (argc > 1)
-   {
-      getCells(std::string(argv[1]),cells);
-   }
-   else
+   std::string filename = "input_file.txt";
+   int chains = 0; //anneal a single chain unless parallel tempering is asked for
+   size_t cacheBytes = 0;
+   uint32_t cacheMinPoints = 64;
+   bool cacheFirstMiss = false;
+   CurvePruning pruning;
+   bool printPlacement = false;
+   std::string netFilename;
+   float wirelengthWeight = 1;
+   std::string batchFilename;
+   std::string designFilename;
+   for (int i = 1; i < argc; i++)
    {
-      getCells("input_file.txt",cells);
-   }
-   std::cout << "NPE: " << initialVerticalNPE << "\n";
-   std::cout << "Cost: " << cost(initialVerticalNPE,cells) << "\n";
-   std::cout << "NPE: " << initialHorizontalNPE << "\n";
-   std::cout << "Cost: " << cost(initialHorizontalNPE,cells) << "\n";
-   std::cout << "NPE: " << initialOtherNPE << "\n";
-   std::cout << "Cost: " << cost(initialOtherNPE,cells) << std::endl;
-
-   return 0;
-}
-
-/***********************************************************************************
- * Function: isValidNPE
- * @brief verifies the the provided Normalized Polish Expression is valid
- * @param npe the Normalized Polish Expression as a string
- * @return true if valid false otherwise
-************************************************************************************/
-bool isValidNPE(std::string npe)
-{
-   int operands = 0;
-   int operators = 0;
-   for (int i = 0; i < npe.size(); i++) 
-   {
-      //if it is an operator check for repeats add to the operator count
-      if ((npe[i] == 'V')||(npe[i] == 'H'))
+      std::string arg = argv[i];
+      if (arg == "-r") //score with the reference merge and check the annealing against it
       {
-         //make sure there are no repeat operators 
-         if(i+1 < npe.size())
-         {
-            if (npe[i] == npe [i+1])
-            {
-               return false;
-            }
-         }
-         operators++;
+         SNode::mergeMode = SNode::REFERENCE;
+      }
+      else if ((arg == "-t") && (i + 1 < argc)) //parallel tempering with this many chains
+      {
+         chains = std::stoi(argv[++i]);
+      }
+      else if ((arg == "-c") && (i + 1 < argc)) //cache sub-expression sizes in this many MB
+      {
+         cacheBytes = std::stoul(argv[++i]) << 20;
+      }
+      else if ((arg == "-m") && (i + 1 < argc)) //only cache merges of at least this many sizes
+      {
+         cacheMinPoints = std::stoul(argv[++i]);
+      }
+      else if (arg == "-a") //cache a sub-expression the first time it misses
+      {
+         cacheFirstMiss = true;
       }
-      else //if it is an operand make sure it is unique and add to operand count
+      else if ((arg == "-n") && (i + 1 < argc)) //add the wirelength of these nets to the cost
       {
-         //if another instance is found return false
-         if (npe.find(npe[i],i+1)!=std::string::npos)
+         netFilename = argv[++i];
+      }
+      else if ((arg == "-w") && (i + 1 < argc)) //weight of the wirelength against the area
+      {
+         wirelengthWeight = std::stof(argv[++i]);
+         if (!(wirelengthWeight >= 0))
          {
-            return false;
+            std::cerr << "The wirelength weight must not be negative\n";
+            return 1;
          }
-         operands++;
       }
-      //make sure it meets balloting property
-      if(operands <= operators)
+      else if ((arg == "-b") && (i + 1 < argc)) //score the expressions of this file, - for stdin
+      {
+         batchFilename = argv[++i];
+      }
+      else if ((arg == "-o") && (i + 1 < argc)) //write the cells as a binary design and stop
+      {
+         designFilename = argv[++i];
+      }
+      else if (arg == "-p") //print where every cell of the best floorplan goes
+      {
+         printPlacement = true;
+      }
+      else if ((arg == "-e") && (i + 1 < argc)) //drop sizes within this fraction of another
       {
-         return false;
+         pruning.epsilon = std::stof(argv[++i]);
+      }
+      else if ((arg == "-k") && (i + 1 < argc)) //keep at most this many sizes per operator
+      {
+         pruning.maxPoints = std::stoul(argv[++i]);
+      }
+      else
+      {
+         filename = arg;
       }
    }
-   if (operators == operands -1)
+   //Cells of the floorplan
+   CellLibrary cells;
+   getCells(filename,cells);
+   if (designFilename != "")
    {
-      return true;
+      writeDesign(designFilename, cells);
+      return 0;
    }
-   return false;
-}
-
-/***********************************************************************************
- * Function: getCells
- * @brief loads the cells for the floorplan from the designated file
- * @param filename the name of the file containing the cells
-************************************************************************************/
-void getCells(std::string filename, std::list<SNode> &cells)
-{
-   if (filename == "")
+   Netlist nets;
+   if (netFilename != "")
    {
-      std::cout << "Please enter file name: ";
-      std::cin.clear();
-      std::cin.ignore();
-      getline(std::cin,filename);
+      getNets(netFilename, cells, nets);
    }
-    // open the file
-   std::ifstream fin(filename);
-   if (fin.fail())
+   const Netlist * netlist = (netFilename != "")? &nets : NULL;
+   if (batchFilename != "")
    {
-      throw "Unable to open file";
+      //only the costs go to standard output so it can be piped
+      std::ios::sync_with_stdio(false);
+      //-t and -p only apply to annealing
+      if ((chains > 0) || printPlacement)
+      {
+         std::cerr << "-t and -p cannot be used with -b\n";
+         return 1;
+      }
+      BatchScorer scorer(cells);
+      scorer.setPruning(pruning);
+      scorer.setNetlist(netlist, wirelengthWeight);
+      scorer.setCache(cacheBytes, cacheMinPoints, cacheFirstMiss);
+      if (batchFilename == "-")
+      {
+         scorer.run(std::cin, std::cout);
+      }
+      else
+      {
+         std::ifstream batch(batchFilename);
+         if (!batch)
+         {
+            throw "Unable to open file";
+         }
+         scorer.run(batch, std::cout);
+      }
+      return 0;
    }
-   
-   //extract the cells from the file
-   std::string line;
-   while(getline(fin,line))
+   //the sample expressions name the cells of the sample input, other designs skip them
+   const std::string initialNPEs[] = {initialVerticalNPE, initialHorizontalNPE, initialOtherNPE};
+   for (int i = 0; i < 3; i++)
    {
-      std::stringstream stream(line);
-      char name;
-      float area;
-      float aspectRatio;
-      stream >> name;
-      stream >> area;
-      stream >> aspectRatio;
-      cells.push_back(SNode(name, area, aspectRatio));
+      NPE npe;
+      try
+      {
+         npe = parseNPE(initialNPEs[i],cells);
+      }
+      catch (const char *)
+      {
+         continue;
+      }
+      std::cout << "NPE: " << initialNPEs[i] << "\n";
+      std::cout << "Cost: " << cost(npe,cells) << "\n";
    }
-}
-
-/***********************************************************************************
- * Function: cost
- * @brief calculates the cost of the Normalized Polish expression given the cells
- *    provided
- * @param npe the Normalized Polish expression
- * @param cells the cells to be arranged
- * @return the area of the overall floorplan
-************************************************************************************/
-float cost(std::string npe ,std::list<SNode> &cells)
-{
-   //create tree from npe
-   std::list<SNode> operators; //list to store operators
-   SNode * root = generateTree(npe, cells, operators);
-   return root->calcMinArea();
-}
 
-/***********************************************************************************
- * Function: generateTree
- * @brief generates a slicing tree from a Normalized Polar Expression 
- * @param npe the Normalized Polar Expression
- * @param cells the cells to be organized
- * @param operators this should be empty but is used to store the operators of the 
- *    tree
- * @return returns a pointer to the root of the tree which is also the first 
- *    element in the operators list
-************************************************************************************/
-SNode * generateTree(std::string npe, std::list<SNode> &cells, std::list<SNode> &operators)
-{
-   operators.clear();
-   //Validate npe
-   if(!isValidNPE(npe))
+   //anneal starting from every cell sliced vertically
+   NPE best;
+   float bestCost;
+   float bestError;
+   if (chains > 0)
    {
-      std::cout << "Invalid NPE!";
-      throw "Invalid NPE!";
+      TemperingSchedule schedule;
+      schedule.chains = chains;
+      schedule.annealing.cacheBytes = cacheBytes;
+      schedule.annealing.cacheMinPoints = cacheMinPoints;
+      schedule.annealing.cacheFirstMiss = cacheFirstMiss;
+      schedule.annealing.pruning = pruning;
+      schedule.annealing.wirelengthWeight = wirelengthWeight;
+      ParallelTempering tempering(cells, verticalNPE(cells), schedule, netlist);
+      tempering.run();
+      std::cout << "Best NPE: " << formatNPE(tempering.bestNPE,cells) << "\n";
+      std::cout << "Best Cost: " << tempering.bestCost << std::endl;
+      std::cout << "Area Error Bound: " << tempering.bestError << std::endl;
+      best = tempering.bestNPE;
+      bestCost = tempering.bestCost;
+      bestError = tempering.bestError;
    }
-   //generate tree
-   std::string::reverse_iterator currentChar = npe.rbegin(); //start from back of string
-   operators.push_back(SNode(*currentChar)); //since it is npe we know this will be an operator
-   SNode * current = &operators.back(); //set root 
-   currentChar++;
-   while (currentChar != npe.rend()) //while there are still characters in NPE
+   else
    {
-      if((*currentChar == 'V') || (*currentChar == 'H')) //its an operator
+      AnnealingSchedule schedule;
+      schedule.cacheBytes = cacheBytes;
+      schedule.cacheMinPoints = cacheMinPoints;
+      schedule.cacheFirstMiss = cacheFirstMiss;
+      schedule.pruning = pruning;
+      schedule.wirelengthWeight = wirelengthWeight;
+      Annealer annealer(cells, verticalNPE(cells), schedule, netlist);
+      annealer.run();
+      std::cout << "Best NPE: " << formatNPE(annealer.bestNPE,cells) << "\n";
+      std::cout << "Best Cost: " << annealer.bestCost << std::endl;
+      std::cout << "Area Error Bound: " << annealer.bestError << std::endl;
+      best = annealer.bestNPE;
+      bestCost = annealer.bestCost;
+      bestError = annealer.bestError;
+      if (cacheBytes > 0)
       {
-         operators.push_back(SNode(*currentChar));
-         if(current->right) //assign right when possible left if not
-         {
-            current->left = &operators.back();
-            current->left->parent = current;
-         }
-         else
-         {
-            current->right = &operators.back();
-            current->right->parent = current;
-         }
-         current = &operators.back();
+         std::cout << "Cache Hit Rate: " << annealer.getCache().hitRate() << std::endl;
       }
-      else //its a operand
+   }
+   if (SNode::mergeMode == SNode::REFERENCE)
+   {
+      //the annealer always merges incrementally, so its best floorplan is scored 
+      //again from scratch by the reference merge
+      float referenceArea = cost(best, cells);
+      std::cout << "Reference Area: " << referenceArea << std::endl;
+      //pruning only ever enlarges the area, by at most the error bound
+      if (!netlist && ((bestCost < referenceArea * 0.9999f) || (bestCost > referenceArea * (1 + bestError) * 1.0001f)))
       {
-         //find the opperand in the cells
-         SNode * child = NULL;
-         for (std::list<SNode>::iterator i = cells.begin(); i != cells.end(); i++)
-         {
-            if (i->name == *currentChar)
-            {
-               child = &(*i);
-            }
-         }
-         //assign it to right if possible left otherwise
-         if(child)
-         {
-            if(current->right) 
-            {
-               current->left = child;
-               while ((current != &operators.front()) && (current->left))
-               {
-                  current = current->parent;
-               }
-            }
-            else
-            {
-               current->right = child;
-            }
-         }
-         else //item not found in cells 
-         {
-            throw "Cell data not valid!";
-         }
+         std::cerr << "The best cost does not match the reference area\n";
+         return 1;
+      }
+   }
+   if (printPlacement)
+   {
+      std::vector<Placement> placements = placeNPE(best, cells, pruning);
+      for (int i = 0; i < cells.size(); i++)
+      {
+         std::cout << cells.cells[i].name << ' ' << placements[i].x << ' ' << placements[i].y
+                   << ' ' << placements[i].width << ' ' << placements[i].height
+                   << (placements[i].rotated? " R" : "") << "\n";
       }
-      currentChar++;
    }
-   return &operators.front();
-}
\ No newline at end of file
+
+   return 0;
+}
@@ -0,0 +1,423 @@
+/***********************************************************************************
+ * Program: Floorplanning self-check
+ * @brief Checks the fast paths of the evaluator against the slow ones they
+ *    replace on random designs: the incremental tree, its undo log, its cutoff,
+ *    the curve cache and the incremental wirelength against building from
+ *    scratch, the linear merge against the reference merge, and a binary design
+ *    against the cells it was written from. Every check is printed, and the
+ *    program exits with 1 if any of them fails
+ * Author: Brandon Baird
+************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "SNode.h"
+#include "Floorplan.h"
+#include "Annealer.h"
+#include "DesignFile.h"
+#include "MappedFile.h"
+
+int failures = 0; //the number of checks that failed
+
+/***********************************************************************************
+ * Function: report
+ * @brief prints the outcome of a check and counts it if it failed
+ * @param passed true if the check passed
+ * @param name what was checked
+************************************************************************************/
+void report(bool passed, const std::string &name)
+{
+   printf("%s %s\n", passed? "ok  " : "FAIL", name.c_str());
+   if (!passed)
+   {
+      failures++;
+   }
+}
+
+/***********************************************************************************
+ * Function: randomCells
+ * @brief fills the library with cells of every kind the cells file allows: single
+ *    shapes, several shapes, and either of them fixed
+ * @param cells the library to fill
+ * @param count the number of cells
+ * @param random the generator to draw from
+************************************************************************************/
+void randomCells(CellLibrary &cells, int count, std::mt19937 &random)
+{
+   std::uniform_real_distribution<float> area(1, 100);
+   std::uniform_real_distribution<float> aspectRatio(0.25f, 4);
+   for (int i = 0; i < count; i++)
+   {
+      std::string name = "c" + std::to_string(i);
+      bool fixed = (random() % 4 == 0);
+      if (random() % 3 == 0)
+      {
+         std::vector<Dimensions> options(1 + random() % 6);
+         for (int k = 0; k < (int)options.size(); k++)
+         {
+            float cellArea = area(random);
+            float ratio = aspectRatio(random);
+            options[k].height = sqrt(cellArea * ratio);
+            options[k].width = cellArea / options[k].height;
+         }
+         cells.add(SNode(name, options, fixed));
+      }
+      else
+      {
+         cells.add(SNode(name, area(random), aspectRatio(random), fixed));
+      }
+   }
+}
+
+/***********************************************************************************
+ * Function: randomCurve
+ * @brief makes a valid shape curve of whole numbers from a small range, so that
+ *    merging two of them produces many sizes of equal width or height
+ * @param size the most sizes of the curve
+ * @param random the generator to draw from
+ * @return the curve, sorted by width with every size shorter than the one before
+************************************************************************************/
+ShapeCurve randomCurve(int size, std::mt19937 &random)
+{
+   ShapeCurve curve;
+   float width = 1 + random() % 3;
+   float height = 1 + size * 3;
+   for (int k = 0; k < size; k++)
+   {
+      Dimensions option;
+      option.width = width;
+      option.height = height;
+      option.rSelected = 0;
+      option.lSelected = 0;
+      curve.push_back(option);
+      width += 1 + random() % 3;
+      height -= 1 + random() % 3;
+      if (height < 1)
+      {
+         break;
+      }
+   }
+   return curve;
+}
+
+/***********************************************************************************
+ * Function: randomMove
+ * @brief picks a random legal M1, M2 or M3 move on an expression
+ * @param state the expression with its operator counts
+ * @param random the generator to draw from
+ * @param move the move to be filled in
+ * @return true if a move was found, false if the one drawn had nothing to apply to
+************************************************************************************/
+bool randomMove(const NPEState &state, std::mt19937 &random, Move &move)
+{
+   const NPE &npe = state.getNPE();
+   int type = random() % 3;
+   if (type == 0)
+   {
+      int k = random() % (state.operandCount() - 1);
+      move.type = 1;
+      move.first = state.operandPosition(k);
+      move.second = state.operandPosition(k + 1);
+      return true;
+   }
+   if (type == 1)
+   {
+      int i = state.operandPosition(random() % state.operandCount());
+      if ((i + 1 >= (int)npe.size()) || !isOperator(npe[i + 1]))
+      {
+         return false;
+      }
+      move.type = 2;
+      move.first = i + 1;
+      move.second = i + 1;
+      while ((move.second < (int)npe.size()) && isOperator(npe[move.second]))
+      {
+         move.second++;
+      }
+      return true;
+   }
+   int i = random() % (state.size() - 1);
+   if (!state.canSwapOperandOperator(i))
+   {
+      return false;
+   }
+   move.type = 3;
+   move.first = i;
+   move.second = i + 1;
+   return true;
+}
+
+/***********************************************************************************
+ * Function: checkIncremental
+ * @brief applies batches of random moves to a tree and compares every evaluation
+ *    with a tree built from scratch, half the time with a cutoff. Half of the
+ *    batches are then rolled back, which must restore the previous expression
+ *    and area exactly
+ * @param cells the cells to be arranged
+ * @param pruning how far the curves are thinned out
+ * @param cache the cache of the incremental tree, or NULL for none
+ * @param steps the number of batches of moves
+ * @param random the generator to draw from
+ * @return true if every evaluation matched
+************************************************************************************/
+bool checkIncremental(const CellLibrary &cells, const CurvePruning &pruning, CurveCache *cache, int steps, std::mt19937 &random)
+{
+   SlicingTree tree;
+   SlicingTree fresh;
+   tree.setPruning(pruning);
+   tree.setCache(cache);
+   fresh.setPruning(pruning);
+   tree.build(verticalNPE(cells), cells);
+   float area = tree.evaluate();
+   std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+   for (int step = 0; step < steps; step++)
+   {
+      NPE before = tree.getNPE();
+      float beforeArea = area;
+      int moves = 1 + random() % 4;
+      for (int m = 0; m < moves; m++)
+      {
+         Move move;
+         while (!randomMove(tree.getState(), random, move))
+         {
+         }
+         tree.apply(move);
+      }
+      fresh.build(tree.getNPE(), cells);
+      float expected = fresh.evaluate();
+      if (random() % 2 == 0)
+      {
+         //an evaluation that is cut off must really be above the cutoff
+         float cutoff = expected * scale(random);
+         float cut = tree.evaluate(cutoff);
+         if ((cut != expected) && !((cut == INFINITY) && (expected > cutoff)))
+         {
+            return false;
+         }
+      }
+      area = tree.evaluate();
+      if ((area != expected) || (tree.areaError() != fresh.areaError()))
+      {
+         return false;
+      }
+      if (random() % 2 == 0)
+      {
+         tree.rollback();
+         area = tree.evaluate();
+         if ((tree.getNPE() != before) || (area != beforeArea))
+         {
+            return false;
+         }
+      }
+      else
+      {
+         tree.commit();
+      }
+   }
+   return true;
+}
+
+/***********************************************************************************
+ * Function: checkWirelength
+ * @brief anneals with random nets and compares the cost the annealer keeps, whose
+ *    wirelength is only updated for the cells that moved, with the area and the
+ *    wirelength of the current expression worked out from scratch
+ * @param cells the cells to be arranged
+ * @param steps the number of annealing steps
+ * @param random the generator to draw from
+ * @return true if every cost matched
+************************************************************************************/
+bool checkWirelength(const CellLibrary &cells, int steps, std::mt19937 &random)
+{
+   Netlist nets;
+   for (int n = 0; n < cells.size(); n++)
+   {
+      std::vector<int32_t> pins(2 + random() % 4);
+      for (int k = 0; k < (int)pins.size(); k++)
+      {
+         pins[k] = random() % cells.size();
+      }
+      nets.addNet(pins);
+   }
+   nets.finish(cells.size());
+   AnnealingSchedule schedule;
+   schedule.seed = random();
+   schedule.wirelengthWeight = 0.5f;
+   Annealer annealer(cells, verticalNPE(cells), schedule, &nets);
+   Wirelength wirelength;
+   wirelength.setNetlist(&nets);
+   for (int step = 0; step < steps; step++)
+   {
+      annealer.step(annealer.currentCost * 0.05f);
+      std::vector<Placement> placements = placeNPE(annealer.getNPE(), cells, schedule.pruning);
+      float expected = cost(annealer.getNPE(), cells) + schedule.wirelengthWeight * wirelength.total(placements);
+      if (fabs(annealer.currentCost - expected) > 1e-4f * expected)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+/***********************************************************************************
+ * Function: checkMerge
+ * @brief merges random curves with both cuts by the linear merge and by the
+ *    reference merge, which must give the same sizes, and checks that every size
+ *    is made from the sizes of the children it names
+ * @param merges the number of pairs of curves
+ * @param random the generator to draw from
+ * @return true if every merge matched
+************************************************************************************/
+bool checkMerge(int merges, std::mt19937 &random)
+{
+   SNode left(verticalCut);
+   SNode right(verticalCut);
+   for (int m = 0; m < merges; m++)
+   {
+      left.sizes = randomCurve(1 + random() % 100, random);
+      right.sizes = randomCurve(1 + random() % 100, random);
+      int32_t cut = (m % 2 == 0)? verticalCut : horizontalCut;
+      SNode linear(cut);
+      SNode reference(cut);
+      linear.left = reference.left = &left;
+      linear.right = reference.right = &right;
+      SNode::mergeMode = SNode::REFERENCE;
+      reference.combineChildren();
+      SNode::mergeMode = SNode::STOCKMEYER;
+      linear.combineChildren();
+      if ((linear.sizes.width != reference.sizes.width) || (linear.sizes.height != reference.sizes.height))
+      {
+         return false;
+      }
+      for (uint32_t k = 0; k < linear.sizes.size(); k++)
+      {
+         Dimensions l = left.sizes[linear.sizes.lSelected[k]];
+         Dimensions r = right.sizes[linear.sizes.rSelected[k]];
+         float width = (cut == verticalCut)? l.width + r.width : std::max(l.width, r.width);
+         float height = (cut == verticalCut)? std::max(l.height, r.height) : l.height + r.height;
+         if ((width != linear.sizes.width[k]) || (height != linear.sizes.height[k]))
+         {
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+/***********************************************************************************
+ * Function: checkDesign
+ * @brief writes the cells as a binary design, reads it back and compares every
+ *    field of every cell. A copy with a size that is not a number and a copy with
+ *    two sizes out of order must both be refused
+ * @param cells the cells to write
+ * @return true if the cells came back unchanged and the damaged copies were refused
+************************************************************************************/
+bool checkDesign(const CellLibrary &cells)
+{
+   char filename[] = "/tmp/selfcheckXXXXXX";
+   int descriptor = mkstemp(filename);
+   if (descriptor < 0)
+   {
+      return false;
+   }
+   close(descriptor);
+   writeDesign(filename, cells);
+   CellLibrary loaded;
+   std::vector<uint64_t> contents; //aligned as a mapping is, for the damaged copies
+   size_t size;
+   {
+      MappedFile file(filename);
+      readDesign(file.data(), file.size(), loaded);
+      size = file.size();
+      contents.resize(size / sizeof(uint64_t) + 1);
+      memcpy(contents.data(), file.data(), size);
+   }
+   unlink(filename);
+   if (loaded.size() != cells.size())
+   {
+      return false;
+   }
+   for (int c = 0; c < cells.size(); c++)
+   {
+      const SNode &a = cells.cells[c];
+      const SNode &b = loaded.cells[c];
+      if ((a.name != b.name) || (a.area != b.area) || (a.aspectRatio != b.aspectRatio) || (a.fixed != b.fixed) ||
+          (a.sizes.width != b.sizes.width) || (a.sizes.height != b.sizes.height) ||
+          (a.sizes.rSelected != b.sizes.rSelected) || (a.sizes.lSelected != b.sizes.lSelected) ||
+          (loaded.findName(b.name) != c))
+      {
+         return false;
+      }
+   }
+   const DesignHeader * header = (const DesignHeader *)contents.data();
+   int refused = 0;
+   for (int damage = 0; damage < 2; damage++)
+   {
+      std::vector<uint64_t> copy = contents;
+      float * copyWidth = (float *)((char *)copy.data() + header->optionWidth);
+      if (damage == 0)
+      {
+         copyWidth[0] = NAN;
+      }
+      else
+      {
+         //the first cell with two sizes gets them in the wrong order
+         for (int c = 0; c < cells.size(); c++)
+         {
+            if (cells.cells[c].sizes.size() > 1)
+            {
+               const uint32_t * optionStart = (const uint32_t *)((char *)copy.data() + header->optionStart);
+               std::swap(copyWidth[optionStart[c]], copyWidth[optionStart[c] + 1]);
+               break;
+            }
+         }
+      }
+      CellLibrary damaged;
+      try
+      {
+         readDesign((const char *)copy.data(), size, damaged);
+      }
+      catch (const char *)
+      {
+         refused++;
+      }
+   }
+   return (refused == 2);
+}
+
+/***********************************************************************************
+ * Function: main
+ * @brief runs every check on a few random designs
+ * @return 0 if every check passed, 1 otherwise
+************************************************************************************/
+int main()
+{
+   std::mt19937 random(1);
+   CurvePruning exact;
+   CurvePruning pruned;
+   pruned.epsilon = 0.02f;
+   pruned.maxPoints = 16;
+   for (int design = 0; design < 3; design++)
+   {
+      CellLibrary cells;
+      int count = 10 + design * 45;
+      randomCells(cells, count, random);
+      std::string name = std::to_string(count) + " cells";
+      CurveCache cache(1 << 20, 0, true);
+      CurveCache tinyCache(64 << 10, 0, true);
+      report(checkIncremental(cells, exact, NULL, 2000, random), "incremental against rebuilt, " + name);
+      report(checkIncremental(cells, pruned, NULL, 2000, random), "incremental against rebuilt with pruning, " + name);
+      report(checkIncremental(cells, exact, &cache, 2000, random), "incremental against rebuilt with a cache, " + name);
+      report(checkIncremental(cells, pruned, &tinyCache, 2000, random), "incremental against rebuilt with pruning and an evicting cache, " + name);
+      report(checkWirelength(cells, 1000, random), "incremental wirelength against measured, " + name);
+      report(checkDesign(cells), "binary design round trip, " + name);
+   }
+   report(checkMerge(2000, random), "linear merge against reference merge");
+   return (failures == 0)? 0 : 1;
+}